@@ -56,6 +56,7 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupFiberDumpSignal(SIGUSR2);
 
   acc::Singleton<HubAdaptor>::get()->addService(
       acc::make_unique<TAsyncServer<EmptyHandler, EmptyProcessor>>("Empty"));
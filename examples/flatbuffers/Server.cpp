@@ -77,6 +77,7 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupFiberDumpSignal(SIGUSR2);
 
   acc::Singleton<HubAdaptor>::get()->addService(
       acc::make_unique<BinaryAsyncServer<Proxy>>("Proxy"));
@@ -44,6 +44,7 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupFiberDumpSignal(SIGUSR2);
 
   auto httpserver = acc::make_unique<HTTPAsyncServer>("HTTP");
   httpserver->addHandler<BaseHandler>("/");
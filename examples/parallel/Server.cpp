@@ -55,7 +55,8 @@ class ParallelHandler : virtual public acc::ParallelIf {
     _return.__set_traceid(acc::generateUuid(query.traceid, "rdde"));
     _return.__set_code(ResultCode::OK);
 
-    // function style parallel executing
+    // function style parallel executing, on pool 0 which must use the
+    // "executor" scheduler
     acc::ParallelScheduler scheduler1(
         acc::Singleton<HubAdaptor>::get()->getSharedCPUThreadPoolExecutor(0));
     for (size_t i = 1; i <= 4; i++) {
@@ -88,6 +89,7 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupFiberDumpSignal(SIGUSR2);
 
   acc::Singleton<HubAdaptor>::get()->addService(
       acc::make_unique<
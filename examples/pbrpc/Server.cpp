@@ -85,6 +85,7 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupFiberDumpSignal(SIGUSR2);
 
   auto service = acc::make_unique<PBAsyncServer>("Proxy");
   service->addService(std::make_shared<ProxyServiceImpl>());
@@ -15,7 +15,7 @@
 static const char* VERSION = "1.1.0";
 
 DEFINE_string(addr, "127.0.0.1:8000", "HOST:PORT");
-DEFINE_string(forward, "", "HOST:PORT");
+DEFINE_string(forward, "", "Balancer name");
 DEFINE_int32(threads, 8, "concurrent threads");
 DEFINE_int32(count, 100, "request count");
 
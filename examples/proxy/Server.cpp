@@ -7,6 +7,7 @@
 #include "raster/framework/Config.h"
 #include "raster/framework/HubAdaptor.h"
 #include "raster/framework/Signal.h"
+#include "raster/net/LoadBalancer.h"
 #include "raster/protocol/thrift/AsyncClient.h"
 #include "raster/protocol/thrift/AsyncServer.h"
 #include "accelerator/Logging.h"
@@ -38,15 +39,19 @@ class ProxyHandler : virtual public ProxyIf {
     _return.__set_traceid(acc::generateUuid(query.traceid, "rdde"));
     _return.__set_code(ResultCode::OK);
 
+    // forward names a balancer of the config
     if (!query.forward.empty()) {
-      Peer peer;
-      peer.setFromIpPort(query.forward);
+      auto balancer = acc::Singleton<LoadBalancerManager>::get()
+        ->getBalancer(query.forward);
       Query q;
       q.__set_traceid(query.traceid);
       q.__set_query(query.query);
-      TAsyncClient<ProxyClient> client(peer);
-      client.setKeepAlive();
-      if (!client.connect() ||
+      ClientOption option;
+      option.timeout.ctimeout = 100000;
+      option.timeout.rtimeout = 1000000;
+      option.timeout.wtimeout = 300000;
+      BalancedClient<TAsyncClient<ProxyClient>> client(balancer, option);
+      if (!balancer ||
           !client.fetch(&ProxyClient::recv_run, _return,
                         &ProxyClient::send_run, q)) {
         _return.__set_code(ResultCode::E_BACKEND_FAILURE);
@@ -72,6 +77,8 @@ int main(int argc, char* argv[]) {
   setupIgnoreSignal(SIGPIPE);
   setupShutdownSignal(SIGINT);
   setupShutdownSignal(SIGTERM);
+  setupReloadSignal(SIGHUP);
+  setupFiberDumpSignal(SIGUSR2);
 
   acc::Singleton<HubAdaptor>::get()->addService(
       acc::make_unique<TAsyncServer<ProxyHandler, ProxyProcessor>>("Proxy"));
@@ -82,6 +89,7 @@ int main(int argc, char* argv[]) {
          {configThreadPool, "thread"},
          {configNet, "net"},
          {configMonitor, "monitor"},
+         {configBalancer, "balancer"},
          {configJobGraph, "job.graph"}
          });
 
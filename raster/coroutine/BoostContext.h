@@ -65,16 +65,23 @@ class Context {
   Context(acc::VoidFunc&& func,
           unsigned char* stackLimit,
           size_t stackSize)
-    : func_(std::move(func)) {
-    auto stackBase = stackLimit + stackSize;
+    : func_(std::move(func)),
+      stackLimit_(stackLimit),
+      stackSize_(stackSize) {
+    reset();
+  }
+
+  // Rebuild the context on the same stack, func will run from the start.
+  void reset() {
+    auto stackBase = stackLimit_ + stackSize_;
 #if BOOST_VERSION >= 106100
     fiberContext_ =
-        boost::context::detail::make_fcontext(stackBase, stackSize, &fiberFunc);
+        boost::context::detail::make_fcontext(stackBase, stackSize_, &fiberFunc);
 #elif BOOST_VERSION >= 105200
     fiberContext_ =
-        boost::context::make_fcontext(stackBase, stackSize, &fiberFunc);
+        boost::context::make_fcontext(stackBase, stackSize_, &fiberFunc);
 #else
-    fiberContext_.fc_stack.limit = stackLimit;
+    fiberContext_.fc_stack.limit = stackLimit_;
     fiberContext_.fc_stack.base = stackBase;
     make_fcontext(&fiberContext_, &fiberFunc);
 #endif
@@ -125,6 +132,8 @@ class Context {
 #endif
 
   acc::VoidFunc func_;
+  unsigned char* stackLimit_;
+  size_t stackSize_;
   FiberContext fiberContext_;
   MainContext mainContext_;
 };
@@ -27,10 +27,17 @@ class Context {
   Context(acc::VoidFunc&& func,
           unsigned char* stackLimit,
           size_t stackSize)
-    : func_(std::move(func)) {
+    : func_(std::move(func)),
+      stackLimit_(stackLimit),
+      stackSize_(stackSize) {
+    reset();
+  }
+
+  // Rebuild the context on the same stack, func will run from the start.
+  void reset() {
     getcontext(&fiberContext_);
-    fiberContext_.uc_stack.ss_sp = stackLimit;
-    fiberContext_.uc_stack.ss_size = stackSize;
+    fiberContext_.uc_stack.ss_sp = stackLimit_;
+    fiberContext_.uc_stack.ss_size = stackSize_;
     makecontext(&fiberContext_, (void (*)())fiberFunc, 1, this);
   }
 
@@ -49,6 +56,8 @@ class Context {
   }
 
   acc::VoidFunc func_;
+  unsigned char* stackLimit_;
+  size_t stackSize_;
   ucontext_t fiberContext_;
   ucontext_t mainContext_;
 };
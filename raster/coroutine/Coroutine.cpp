@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/Coroutine.h"
+
+#if RDD_HAVE_COROUTINE
+
+#include "accelerator/Logging.h"
+#include "raster/coroutine/FiberScheduler.h"
+
+namespace rdd {
+
+void StacklessTask::handle() {
+  if (!started_) {
+    started_ = true;
+    if (FiberScheduler::expired(this)) {
+      FiberScheduler::drop(this);
+      return;
+    }
+    coroutine_ = start();
+    coroutine_.handle().promise().task = this;
+    next_ = coroutine_.handle();
+  }
+  std::exchange(next_, nullptr).resume();
+  if (coroutine_.done()) {
+    try {
+      coroutine_.handle().promise().result();
+    } catch (std::exception& e) {
+      ACCLOG(WARN) << "catch exception: " << e.what();
+    } catch (...) {
+      ACCLOG(WARN) << "catch unknown exception";
+    }
+    finish();
+    if (scheduleCallback) {
+      scheduleCallback();
+    }
+    delete this;
+    return;
+  }
+  // callbacks are one-shot, they may resume the task on another thread
+  std::vector<acc::VoidFunc> callbacks;
+  callbacks.swap(blockCallbacks);
+  for (auto& fn : callbacks) {
+    fn();
+  }
+}
+
+} // namespace rdd
+
+#endif
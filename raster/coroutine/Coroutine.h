@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "raster/Portability.h"
+
+#if RDD_HAVE_COROUTINE
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "raster/coroutine/Fiber.h"
+
+/*
+ * Stackless (C++20) coroutines run by FiberHub pools.
+ *
+ * A StacklessTask owns a CoTask chain instead of a fiber stack.  Where a
+ * fiber would FiberManager::yield(), a coroutine does co_await coYield():
+ * the block callbacks of the task run after it is suspended, and the task
+ * is resumed on its pool when the awaited event completes.
+ *
+ * Coroutines must not call blocking fiber APIs (FiberManager::yield,
+ * FiberBaton, ...), they are not in a fiber.
+ */
+namespace rdd {
+
+template <class T = void> class CoTask;
+
+namespace detail {
+
+struct CoPromiseBase {
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <class P>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<P> h) noexcept {
+      auto next = h.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { error = std::current_exception(); }
+
+  void rethrow() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  std::coroutine_handle<> continuation;
+  Fiber::Task* task{nullptr};  // which runs the coroutine chain
+  std::exception_ptr error;
+};
+
+template <class T>
+struct CoPromise : CoPromiseBase {
+  CoTask<T> get_return_object();
+
+  template <class U>
+  void return_value(U&& v) { value = std::forward<U>(v); }
+
+  T result() {
+    rethrow();
+    return std::move(value);
+  }
+
+  T value{};
+};
+
+template <>
+struct CoPromise<void> : CoPromiseBase {
+  CoTask<void> get_return_object();
+
+  void return_void() {}
+
+  void result() { rethrow(); }
+};
+
+} // namespace detail
+
+/*
+ * Lazy coroutine, started by co_await in another coroutine (or by a
+ * StacklessTask).  The result or exception is taken by co_await.
+ */
+template <class T>
+class CoTask {
+ public:
+  typedef detail::CoPromise<T> promise_type;
+  typedef std::coroutine_handle<promise_type> Handle;
+
+  CoTask() {}
+  explicit CoTask(Handle h) : handle_(h) {}
+
+  CoTask(CoTask&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  CoTask& operator=(CoTask&& other) noexcept {
+    if (this != &other) {
+      destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  ~CoTask() { destroy(); }
+
+  bool await_ready() const noexcept { return done(); }
+
+  template <class P>
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<P> parent) noexcept {
+    handle_.promise().continuation = parent;
+    handle_.promise().task = parent.promise().task;
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().result(); }
+
+  Handle handle() const { return handle_; }
+
+  bool done() const { return !handle_ || handle_.done(); }
+
+  CoTask(const CoTask&) = delete;
+  CoTask& operator=(const CoTask&) = delete;
+
+ private:
+  void destroy() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+
+  Handle handle_;
+};
+
+namespace detail {
+
+template <class T>
+inline CoTask<T> CoPromise<T>::get_return_object() {
+  return CoTask<T>(CoTask<T>::Handle::from_promise(*this));
+}
+
+inline CoTask<void> CoPromise<void>::get_return_object() {
+  return CoTask<void>(CoTask<void>::Handle::from_promise(*this));
+}
+
+} // namespace detail
+
+/*
+ * Fiber task running a coroutine without stack.
+ *
+ * The first handle() creates the coroutine by start(), or drops the task
+ * if its deadline has passed.  Each handle() resumes the coroutine where
+ * it was suspended; when it returns, finish() and scheduleCallback are
+ * called and the task deletes itself.
+ */
+class StacklessTask : public Fiber::Task {
+ public:
+  StacklessTask() { stackless = true; }
+  ~StacklessTask() override {}
+
+  void handle() override final;
+
+  // Set by the awaiter which suspends the coroutine.
+  void suspend(std::coroutine_handle<> h) { next_ = h; }
+
+ protected:
+  virtual CoTask<> start() = 0;
+  virtual void finish() {}
+
+ private:
+  CoTask<> coroutine_;
+  std::coroutine_handle<> next_;
+  bool started_{false};
+};
+
+/*
+ * Suspend the coroutine until its task is resumed (by an event added in
+ * the block callbacks, as AsyncClient::connect does).  Return false if
+ * not run by a StacklessTask.
+ */
+class CoYield {
+ public:
+  bool await_ready() const noexcept { return false; }
+
+  template <class P>
+  bool await_suspend(std::coroutine_handle<P> h) noexcept {
+    auto task = static_cast<StacklessTask*>(h.promise().task);
+    if (!task) {
+      ok_ = false;
+      return false;
+    }
+    task->suspend(h);
+    return true;
+  }
+
+  bool await_resume() const noexcept { return ok_; }
+
+ private:
+  bool ok_{true};
+};
+
+inline CoYield coYield() { return CoYield(); }
+
+} // namespace rdd
+
+#endif
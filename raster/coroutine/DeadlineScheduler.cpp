@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/DeadlineScheduler.h"
+
+#include <limits>
+
+#include "accelerator/Logging.h"
+#include "accelerator/stats/Monitor.h"
+
+namespace rdd {
+
+namespace {
+
+inline uint64_t deadlineOf(const Fiber::Task* task) {
+  return task->deadline > 0
+    ? task->deadline : std::numeric_limits<uint64_t>::max();
+}
+
+}
+
+// priority_queue pops the greatest
+bool DeadlineScheduler::Item::operator<(const Item& other) const {
+  if (task->priority != other.task->priority) {
+    return task->priority < other.task->priority;
+  }
+  uint64_t d1 = deadlineOf(task);
+  uint64_t d2 = deadlineOf(other.task);
+  if (d1 != d2) {
+    return d1 > d2;
+  }
+  return seq > other.seq;
+}
+
+DeadlineScheduler::DeadlineScheduler(
+    size_t threadCount,
+    std::shared_ptr<acc::ThreadFactory> threadFactory)
+  : threadFactory_(threadFactory) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads_.push_back(threadFactory_->newThread([this]() { loop(); }));
+  }
+}
+
+DeadlineScheduler::~DeadlineScheduler() {
+  stop();
+}
+
+void DeadlineScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (stop_.exchange(true)) {
+      return;
+    }
+    cond_.notify_all();
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  // no worker runs the tasks left any more
+  std::priority_queue<Item> left;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    left.swap(queue_);
+  }
+  while (!left.empty()) {
+    abandon(left.top().task);
+    left.pop();
+  }
+}
+
+void DeadlineScheduler::schedule(Fiber::Task* task) {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!stop_) {
+      queue_.push({task, seq_++});
+      cond_.notify_one();
+      return;
+    }
+  }
+  abandon(task);
+}
+
+void DeadlineScheduler::abandon(Fiber::Task* task) {
+  if (task->fiber || task->stackless) {
+    // suspended, its stack can not be unwound from here
+    ACCLOG(WARN) << name() << " stopped, lose a started task";
+    ACCMON_CNT("fiber.stop_lost");
+    return;
+  }
+  ACCLOG(V1) << name() << " stopped, drop a task";
+  ACCMON_CNT("fiber.stop_drop");
+  discard(task);
+}
+
+void DeadlineScheduler::loop() {
+  while (true) {
+    Fiber::Task* task;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        break;
+      }
+      task = queue_.top().task;
+      queue_.pop();
+    }
+    run(task);
+  }
+}
+
+} // namespace rdd
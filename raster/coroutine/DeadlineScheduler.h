@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "raster/coroutine/FiberScheduler.h"
+
+namespace rdd {
+
+/*
+ * Priority and earliest-deadline-first fiber scheduler.
+ *
+ * Runnable tasks are ordered by priority (higher first), then by
+ * deadline (earlier first, tasks without deadline last), then FIFO.
+ * Resumed fibers keep the deadline of their task, so a request close to
+ * its budget overtakes fresh ones.
+ */
+class DeadlineScheduler : public FiberScheduler {
+ public:
+  DeadlineScheduler(size_t threadCount,
+                    std::shared_ptr<acc::ThreadFactory> threadFactory);
+
+  ~DeadlineScheduler() override;
+
+  void schedule(Fiber::Task* task) override;
+
+  std::string name() const override {
+    return threadFactory_->namePrefix();
+  }
+
+  // Join the workers; the tasks left, or scheduled after, are dropped
+  // (started ones are only counted).
+  void stop();
+
+ private:
+  struct Item {
+    Fiber::Task* task;
+    uint64_t seq;
+
+    bool operator<(const Item& other) const;
+  };
+
+  void loop();
+  void abandon(Fiber::Task* task);
+
+  std::shared_ptr<acc::ThreadFactory> threadFactory_;
+  std::vector<std::thread> threads_;
+
+  std::mutex lock_;
+  std::condition_variable cond_;
+  std::priority_queue<Item> queue_;
+  uint64_t seq_{0};
+
+  std::atomic<bool> stop_{false};
+};
+
+} // namespace rdd
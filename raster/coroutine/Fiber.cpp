@@ -16,8 +16,12 @@
 
 #include "raster/coroutine/Fiber.h"
 
+#include "accelerator/Conv.h"
 #include "accelerator/Logging.h"
+#include "accelerator/stats/Monitor.h"
 #include "raster/coroutine/FiberManager.h"
+#include "raster/coroutine/FiberRegistry.h"
+#include "raster/coroutine/StackPool.h"
 
 #define RDD_FIBER_STR(status) #status
 
@@ -25,6 +29,9 @@ namespace {
   static const char* statusStrings[] = {
     RDD_FIBER_GEN(RDD_FIBER_STR)
   };
+  static const char* waitReasonStrings[] = {
+    RDD_FIBER_WAIT_GEN(RDD_FIBER_STR)
+  };
 }
 
 namespace rdd {
@@ -34,48 +41,136 @@ void Fiber::Task::run() {
   FiberManager::exit();
 }
 
+constexpr size_t Fiber::kMaxTimestamps;
+constexpr size_t Fiber::kMaxWaitDetail;
+
 std::atomic<size_t> Fiber::count_(0);
 
+Fiber::Fiber(int stackSize)
+  : stackLimit_(StackPool::get()->allocate(StackPool::roundSize(stackSize))),
+    stackSize_(StackPool::roundSize(stackSize)),
+    context_([this]() { run(); }, stackLimit_, stackSize_) {
+  for (auto& c : waitDetail_) {
+    c.store(0, std::memory_order_relaxed);
+  }
+  FiberRegistry::get()->add(this);
+}
+
 Fiber::Fiber(int stackSize, std::unique_ptr<Task> task)
-  : task_(std::move(task)),
-    stackLimit_(new unsigned char[stackSize]),
-    stackSize_(stackSize),
-    context_(std::bind(&Task::run, task_.get()), stackLimit_, stackSize_) {
-  task_->fiber = this;
-  timestamps_.push_back(std::move(acc::Timestamp(status_)));
-  ++count_;
+  : Fiber(stackSize) {
+  reset(std::move(task));
 }
 
 Fiber::~Fiber() {
-  delete [] stackLimit_;
-  --count_;
+  FiberRegistry::get()->remove(this);
+  reset(nullptr);
+  StackPool::get()->deallocate(stackLimit_, stackSize_);
+}
+
+void Fiber::reset(std::unique_ptr<Task> task) {
+  if (task_) {
+    if (painted_) {
+      // by service: the pool of a request task is its channel id
+      size_t used;
+      auto id = acc::to<std::string>(task_->poolId);
+      if (StackPool::highWaterMark(stackLimit_, stackSize_, used)) {
+        ACCMON_AVG("fiber.stack_used-" + id, used);
+        ACCMON_MAX("fiber.stack_used-" + id + ".max", used);
+      } else {
+        ACCMON_CNT("fiber.stack_shallow-" + id);
+      }
+      painted_ = false;
+    }
+    --count_;
+  }
+  task_ = std::move(task);
+  status_.store(kInit, std::memory_order_relaxed);
+  waitReason_.store(kWaitNone, std::memory_order_relaxed);
+  timestampCount_ = 0;
+  if (task_) {
+    task_->fiber = this;
+    timestamps_[timestampCount_++] = acc::Timestamp(kInit);
+    starttime_.store(timestamps_[0].stamp, std::memory_order_relaxed);
+    statusTime_.store(timestamps_[0].stamp, std::memory_order_relaxed);
+    poolId_.store(task_->poolId, std::memory_order_relaxed);
+    painted_ = StackPool::get()->paint(stackLimit_, stackSize_);
+    context_.reset();
+    ++count_;
+  } else {
+    poolId_.store(-1, std::memory_order_relaxed);
+  }
+}
+
+void Fiber::run() {
+  task_->run();
 }
 
 void Fiber::setStatus(int status) {
-  status_ = status;
-  timestamps_.push_back(std::move(acc::Timestamp(status, cost())));
+  uint64_t now = acc::timestampNow();
+  status_.store(status, std::memory_order_relaxed);
+  statusTime_.store(now, std::memory_order_relaxed);
+  if (timestampCount_ < kMaxTimestamps) {
+    ++timestampCount_;
+  }
+  timestamps_[timestampCount_ - 1] = acc::Timestamp(status, now - starttime());
 }
 
 const char* Fiber::statusName() const {
-  return statusStrings[status_];
+  return statusName(status());
+}
+
+const char* Fiber::statusName(int status) {
+  return statusStrings[status];
+}
+
+void Fiber::setWait(int reason, const char* detail) {
+  uint32_t seq = waitSeq_.load(std::memory_order_relaxed);
+  waitSeq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  size_t n = 0;
+  for (; n < kMaxWaitDetail - 1 && detail[n]; ++n) {
+    waitDetail_[n].store(detail[n], std::memory_order_relaxed);
+  }
+  waitDetail_[n].store(0, std::memory_order_relaxed);
+  waitSeq_.store(seq + 2, std::memory_order_release);
+  waitReason_.store(reason, std::memory_order_relaxed);
+}
+
+std::string Fiber::waitDetail() const {
+  char buf[kMaxWaitDetail];
+  uint32_t seq;
+  do {
+    seq = waitSeq_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < kMaxWaitDetail; ++i) {
+      buf[i] = waitDetail_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != waitSeq_.load(std::memory_order_relaxed));
+  buf[kMaxWaitDetail - 1] = 0;
+  return buf;
+}
+
+const char* Fiber::waitReasonName(int reason) {
+  return waitReasonStrings[reason];
 }
 
 void Fiber::execute() {
-  assert(status_ == kRunable);
+  assert(status() == kRunable);
+  waitReason_.store(kWaitNone, std::memory_order_relaxed);
   setStatus(kRunning);
   ACCLOG(V5) << *this << " execute";
   context_.activate();
 }
 
 void Fiber::yield(int status) {
-  assert(status_ == kRunning);
+  assert(this->status() == kRunning);
   setStatus(status);
   ACCLOG(V5) << *this << " yield";
   context_.deactivate();
 }
 
 uint64_t Fiber::starttime() const {
-  return timestamps_.front().stamp;
+  return starttime_.load(std::memory_order_relaxed);
 }
 
 uint64_t Fiber::cost() const {
@@ -83,7 +178,9 @@ uint64_t Fiber::cost() const {
 }
 
 std::string Fiber::timestampStr() const {
-  return acc::join("-", timestamps_);
+  return acc::join("-",
+                   timestamps_.begin(),
+                   timestamps_.begin() + timestampCount_);
 }
 
 std::ostream& operator<<(std::ostream& os, const Fiber& fiber) {
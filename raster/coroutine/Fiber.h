@@ -16,16 +16,20 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cassert>
-#include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "accelerator/Time.h"
 #include "raster/coroutine/BoostContext.h"
 
 namespace rdd {
 
+class FiberHub;
+
 #define RDD_FIBER_GEN(x) \
     x(Init),             \
     x(Runable),          \
@@ -33,18 +37,51 @@ namespace rdd {
     x(Block),            \
     x(Exit)
 
+#define RDD_FIBER_WAIT_GEN(x) \
+    x(None),                  \
+    x(Backend),               \
+    x(Group),                 \
+    x(Lock),                  \
+    x(Timer),                 \
+    x(Offload),               \
+    x(IO),                    \
+    x(Other)
+
 #define RDD_FIBER_ENUM(status) k##status
+#define RDD_FIBER_WAIT_ENUM(reason) kWait##reason
 
 class Fiber {
  public:
   struct Task {
     virtual ~Task() {}
     virtual void handle() = 0;
+    // Called instead of handle() if the task is dropped before it runs,
+    // then scheduleCallback is called and the task deleted.
+    virtual void drop() {}
     void run();
 
-    Fiber* fiber;
-    std::list<acc::VoidFunc> blockCallbacks;
+    Fiber* fiber{nullptr};
+    std::vector<acc::VoidFunc> blockCallbacks;
     acc::VoidFunc scheduleCallback;
+
+    // where the task is scheduled, set by FiberHub
+    FiberHub* hub{nullptr};
+    int poolId{0};
+    size_t stackSize{0};
+    bool ioRun{false};    // run on the IO loop which schedules it
+    void* ioHome{nullptr};  // the IO loop it runs inline on
+
+    uint64_t deadline{0}; // timestamp (us) to finish by, 0 for none
+    int priority{0};      // higher runs first, by DeadlineScheduler
+
+    // A stackless task never gets a fiber, each schedule calls handle()
+    // to resume it (see StacklessTask).
+    bool stackless{false};
+
+    int lastThread{-1};   // worker which last ran the task, by scheduler
+
+    // events left of a group wait, the last one resumes the task
+    std::atomic<size_t> waitCount{0};
   };
 
  public:
@@ -52,18 +89,48 @@ class Fiber {
     RDD_FIBER_GEN(RDD_FIBER_ENUM)
   };
 
+  enum WaitReason {
+    RDD_FIBER_WAIT_GEN(RDD_FIBER_WAIT_ENUM)
+  };
+
   static size_t count() { return count_; }
 
+  explicit Fiber(int stackSize);
   Fiber(int stackSize, std::unique_ptr<Task> task);
 
   ~Fiber();
 
+  // Re-arm the fiber with a new task (nullptr to disarm), the stack and
+  // context are reused.
+  void reset(std::unique_ptr<Task> task);
+
   Task* task() const { return task_.get(); }
 
-  int status() const { return status_; }
+  size_t stackSize() const { return stackSize_; }
+
+  int status() const { return status_.load(std::memory_order_relaxed); }
   void setStatus(int status);
 
   const char* statusName() const;
+  static const char* statusName(int status);
+
+  // Timestamp of entering the current status.
+  uint64_t statusTime() const {
+    return statusTime_.load(std::memory_order_relaxed);
+  }
+
+  // What the fiber is going to block on, set by the running fiber before
+  // it yields, cleared when it runs again.  Readable from other threads.
+  void setWait(int reason, const char* detail = "");
+  int waitReason() const {
+    return waitReason_.load(std::memory_order_relaxed);
+  }
+  std::string waitDetail() const;
+
+  static const char* waitReasonName(int reason);
+
+  // Pool (service port for requests) of the task, -1 if no task.
+  int poolId() const { return poolId_.load(std::memory_order_relaxed); }
 
   void execute();
   void yield(int status);
@@ -77,20 +144,42 @@ class Fiber {
   Fiber& operator=(const Fiber&) = delete;
 
  private:
+  friend class FiberManager;
+
+  static constexpr size_t kMaxTimestamps = 16;
+  static constexpr size_t kMaxWaitDetail = 64;
+
   static std::atomic<size_t> count_;
 
+  void run();
+
   std::unique_ptr<Task> task_;
 
   unsigned char* stackLimit_;
   size_t stackSize_;
   Context context_;
-
-  int status_{kInit};
-  std::vector<acc::Timestamp> timestamps_;
+  bool painted_{false};
+
+  // read by FiberRegistry snapshots, so atomic (relaxed)
+  std::atomic<int> status_{kInit};
+  std::atomic<uint64_t> statusTime_{0};
+  std::atomic<uint64_t> starttime_{0};
+  std::atomic<int> poolId_{-1};
+  std::atomic<int> waitReason_{kWaitNone};
+  // seqlock: odd while writing
+  std::atomic<uint32_t> waitSeq_{0};
+  std::array<std::atomic<char>, kMaxWaitDetail> waitDetail_;
+
+  // timestamps beyond kMaxTimestamps overwrite the last one
+  std::array<acc::Timestamp, kMaxTimestamps> timestamps_;
+  size_t timestampCount_{0};
+
+  Fiber* next_{nullptr};  // FiberManager cache
 };
 
 std::ostream& operator<<(std::ostream& os, const Fiber& fiber);
 
 #undef RDD_FIBER_ENUM
+#undef RDD_FIBER_WAIT_ENUM
 
 } // namespace rdd
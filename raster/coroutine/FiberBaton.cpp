@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/coroutine/FiberBaton.h"
+
+#include "accelerator/Logging.h"
+#include "raster/coroutine/FiberHub.h"
+#include "raster/coroutine/FiberManager.h"
+
+namespace rdd {
+
+constexpr intptr_t FiberBaton::kInit;
+constexpr intptr_t FiberBaton::kPosted;
+constexpr intptr_t FiberBaton::kThreadWaiting;
+
+void FiberBaton::wait(const char* what) {
+  wait(what, Fiber::kWaitLock);
+}
+
+void FiberBaton::wait(const char* what, int reason) {
+  if (ready()) {
+    return;
+  }
+  Fiber* fiber = FiberManager::get();
+  if (fiber) {
+    fiber->setWait(reason, what);
+    // publish the waiter after the fiber is switched out, so post() can
+    // not resume it while it is still running
+    fiber->task()->blockCallbacks.push_back([this, fiber]() {
+      intptr_t expected = kInit;
+      if (!state_.compare_exchange_strong(expected,
+                                          reinterpret_cast<intptr_t>(fiber),
+                                          std::memory_order_acq_rel)) {
+        assert(expected == kPosted);
+        FiberHub::resume(fiber);
+      }
+    });
+    FiberManager::yield();
+    return;
+  }
+  intptr_t expected = kInit;
+  if (state_.compare_exchange_strong(expected, kThreadWaiting,
+                                     std::memory_order_acq_rel)) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() { return ready(); });
+  }
+}
+
+void FiberBaton::post() {
+  intptr_t state = state_.load(std::memory_order_acquire);
+  while (true) {
+    assert(state != kPosted);
+    if (state == kThreadWaiting) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      state_.store(kPosted, std::memory_order_release);
+      cond_.notify_one();
+      return;
+    }
+    if (state_.compare_exchange_weak(state, kPosted,
+                                     std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+  if (state != kInit) {
+    FiberHub::resume(reinterpret_cast<Fiber*>(state));
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace rdd {
+
+/*
+ * One-shot wait/post.
+ *
+ * wait() in a fiber parks the fiber, post() resumes it through FiberHub
+ * on the pool it was scheduled on.  wait() on a plain thread blocks the
+ * thread.  Only one waiter is allowed, call reset() before reusing.
+ */
+class FiberBaton {
+ public:
+  FiberBaton() {}
+
+  // what: wait detail for FiberRegistry
+  void wait(const char* what = "baton");
+  // reason: Fiber::kWait*, kWaitLock by default
+  void wait(const char* what, int reason);
+  void post();
+
+  bool ready() const {
+    return state_.load(std::memory_order_acquire) == kPosted;
+  }
+
+  void reset() {
+    state_.store(kInit, std::memory_order_relaxed);
+  }
+
+  FiberBaton(const FiberBaton&) = delete;
+  FiberBaton& operator=(const FiberBaton&) = delete;
+
+ private:
+  // other values are the waiting Fiber*
+  static constexpr intptr_t kInit = 0;
+  static constexpr intptr_t kPosted = 1;
+  static constexpr intptr_t kThreadWaiting = 2;
+
+  std::atomic<intptr_t> state_{kInit};
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+} // namespace rdd
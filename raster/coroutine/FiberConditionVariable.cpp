@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/coroutine/FiberConditionVariable.h"
+
+namespace rdd {
+
+void FiberConditionVariable::notify_one() {
+  FiberBaton* baton = nullptr;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (!waiters_.empty()) {
+      baton = waiters_.front();
+      waiters_.pop_front();
+    }
+  }
+  if (baton) {
+    baton->post();
+  }
+}
+
+void FiberConditionVariable::notify_all() {
+  std::deque<FiberBaton*> waiters;
+  {
+    acc::SpinLockGuard guard(lock_);
+    waiters.swap(waiters_);
+  }
+  for (auto& baton : waiters) {
+    baton->post();
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "accelerator/thread/SpinLock.h"
+#include "raster/coroutine/FiberBaton.h"
+
+namespace rdd {
+
+/*
+ * Condition variable which parks the fiber instead of blocking the
+ * thread, works with any lockable (FiberMutex usually).
+ */
+class FiberConditionVariable {
+ public:
+  FiberConditionVariable() {}
+
+  template <class Lock>
+  void wait(Lock& lock) {
+    FiberBaton baton;
+    {
+      acc::SpinLockGuard guard(lock_);
+      waiters_.push_back(&baton);
+    }
+    lock.unlock();
+    baton.wait("condition_variable");
+    lock.lock();
+  }
+
+  template <class Lock, class Predicate>
+  void wait(Lock& lock, Predicate pred) {
+    while (!pred()) {
+      wait(lock);
+    }
+  }
+
+  void notify_one();
+  void notify_all();
+
+  FiberConditionVariable(const FiberConditionVariable&) = delete;
+  FiberConditionVariable& operator=(const FiberConditionVariable&) = delete;
+
+ private:
+  acc::SpinLock lock_;
+  std::deque<FiberBaton*> waiters_;
+};
+
+} // namespace rdd
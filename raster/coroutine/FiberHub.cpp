@@ -16,34 +16,98 @@
 
 #include "raster/coroutine/FiberHub.h"
 
+#include "accelerator/Logging.h"
 #include "raster/Portability.h"
 #include "raster/coroutine/FiberManager.h"
 
 DEFINE_uint64(fc_limit, 16384,      // 1GB / 64KB
-              "Limit # of fiber context (warning).");
+              "Limit # of fiber context, new requests are rejected beyond.");
 
 DEFINE_uint64(fc_stack_size, 65536, // 64KB
               "Stack size of fiber context.");
 
 namespace rdd {
 
+__thread void* FiberHub::ioLoop_ = nullptr;
+
+FiberHub::IoScope::IoScope(void* loop) : saved_(ioLoop_) {
+  ioLoop_ = loop;
+}
+
+FiberHub::IoScope::~IoScope() {
+  ioLoop_ = saved_;
+}
+
+bool FiberHub::runInline(Fiber::Task* task) {
+  if (!task->ioRun || !ioLoop_ || getCurrentFiberTask()) {
+    return false;
+  }
+  if (!task->ioHome) {
+    task->ioHome = ioLoop_;
+  }
+  return task->ioHome == ioLoop_;
+}
+
+void FiberHub::resume(Fiber* fiber) {
+  Fiber::Task* task = fiber->task();
+  if (!task->hub) {
+    ACCLOG(FATAL) << *fiber << " is not scheduled by FiberHub";
+    return;
+  }
+  task->hub->execute(fiber, task->poolId);
+}
+
+void FiberHub::resume(Fiber::Task* task) {
+  if (!task->hub) {
+    ACCLOG(FATAL) << "stackless task is not scheduled by FiberHub";
+    return;
+  }
+  if (runInline(task)) {
+    FiberManager::run(task);
+    return;
+  }
+  task->hub->getFiberScheduler(task->poolId)->schedule(task);
+}
+
 void FiberHub::execute(Fiber* fiber, int poolId) {
-  auto executor = getCPUThreadPoolExecutor(poolId);
-  ACCLOG(V2) << executor->getThreadFactory()->namePrefix()
-             << "* add " << *fiber;
-  executor->add([&]() { FiberManager::run(fiber); });
+  if (runInline(fiber->task())) {
+    ACCLOG(V2) << "inline run " << *fiber;
+    FiberManager::run(fiber);
+    return;
+  }
+  auto scheduler = getFiberScheduler(poolId);
+  ACCLOG(V2) << scheduler->name() << "* add " << *fiber;
+  scheduler->schedule(fiber->task());
 }
 
-void FiberHub::execute(std::unique_ptr<Fiber::Task> task, int poolId) {
-  Fiber* fiber = task->fiber;
-  if (!fiber) {
-    if (Fiber::count() >= FLAGS_fc_limit) {
-      ACCLOG(WARN) << "exceed fiber capacity";
-      // still add fiber
+void FiberHub::execute(std::unique_ptr<Fiber::Task> task,
+                       int poolId,
+                       size_t stackSize,
+                       bool ioRun) {
+  if (task->fiber) {
+    // already owned by its fiber
+    execute(task.release()->fiber, poolId);
+    return;
+  }
+  if (!task->stackless && Fiber::count() >= FLAGS_fc_limit) {
+    ACCLOG(WARN) << "exceed fiber capacity";
+    // still add fiber
+  }
+  task->hub = this;
+  task->poolId = poolId;
+  task->stackSize = stackSize > 0 ? stackSize : FLAGS_fc_stack_size;
+  task->ioRun = ioRun;
+  if (runInline(task.get())) {
+    if (task->stackless) {
+      FiberManager::run(task.release());
+    } else {
+      FiberManager::run(
+          FiberManager::create(task->stackSize, std::move(task)));
     }
-    fiber = new Fiber(FLAGS_fc_stack_size, std::move(task));
+    return;
   }
-  execute(fiber, poolId);
+  // the fiber is taken from the cache of the thread which runs it
+  getFiberScheduler(poolId)->schedule(task.release());
 }
 
 } // namespace rdd
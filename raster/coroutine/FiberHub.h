@@ -16,17 +16,58 @@
 
 #pragma once
 
-#include "accelerator/concurrency/CPUThreadPoolExecutor.h"
+#include "raster/Portability.h"
 #include "raster/coroutine/Fiber.h"
+#include "raster/coroutine/FiberScheduler.h"
+
+DECLARE_uint64(fc_limit);
+DECLARE_uint64(fc_stack_size);
 
 namespace rdd {
 
 class FiberHub {
  public:
-  virtual acc::CPUThreadPoolExecutor* getCPUThreadPoolExecutor(int poolId) = 0;
+  /*
+   * Marks the calling thread as running the IO loop for the scope.  An
+   * ioRun task runs inline only in the scope of the loop it first ran
+   * on, resumed from anywhere else (offload, another loop, a thread
+   * posting a baton) it goes to its pool.
+   */
+  class IoScope {
+   public:
+    explicit IoScope(void* loop);
+    ~IoScope();
+
+    IoScope(const IoScope&) = delete;
+    IoScope& operator=(const IoScope&) = delete;
+
+   private:
+    void* saved_;
+  };
+
+  // Loop of the current IoScope, nullptr if none.
+  static void* ioLoop() { return ioLoop_; }
+
+  virtual FiberScheduler* getFiberScheduler(int poolId) = 0;
+
+  // Resume a blocked fiber on the hub and pool it was scheduled on.
+  static void resume(Fiber* fiber);
+  static void resume(Fiber::Task* task);  // stackless
 
   void execute(Fiber* fiber, int poolId);
-  void execute(std::unique_ptr<Fiber::Task> task, int poolId);
+  // stackSize 0 means FLAGS_fc_stack_size.
+  // With ioRun the fiber runs (and resumes) on the calling IO loop, if
+  // in an IoScope and not in another fiber or stackless task; else it
+  // goes to the pool.
+  void execute(std::unique_ptr<Fiber::Task> task,
+               int poolId,
+               size_t stackSize = 0,
+               bool ioRun = false);
+
+ private:
+  static bool runInline(Fiber::Task* task);
+
+  static __thread void* ioLoop_;
 };
 
 } // namespace rdd
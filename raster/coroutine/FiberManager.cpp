@@ -18,9 +18,15 @@
 
 #include "accelerator/Logging.h"
 
+DEFINE_uint64(fc_cache_size, 256,
+              "# of exited fibers cached per thread for reuse.");
+
 namespace rdd {
 
 __thread Fiber* FiberManager::fiber_ = nullptr;
+__thread Fiber::Task* FiberManager::task_ = nullptr;
+__thread Fiber* FiberManager::cache_[StackPool::kClassCount];
+__thread size_t FiberManager::cacheSize_ = 0;
 
 void FiberManager::update(Fiber* fiber) {
   fiber_ = fiber;
@@ -34,16 +40,20 @@ void FiberManager::run(Fiber* fiber) {
   update(fiber);
   fiber->setStatus(Fiber::kRunable);
   fiber->execute();
+  update(nullptr);
   switch (fiber->status()) {
     case Fiber::kBlock: {
-      for (auto& fn : fiber->task()->blockCallbacks) {
+      // callbacks are one-shot, they may resume the fiber on another thread
+      std::vector<acc::VoidFunc> callbacks;
+      callbacks.swap(fiber->task()->blockCallbacks);
+      for (auto& fn : callbacks) {
         fn();
       }
       break;
     }
     case Fiber::kExit: {
       fiber->task()->scheduleCallback();
-      delete fiber;
+      recycle(fiber);
       break;
     }
     default: {
@@ -54,6 +64,13 @@ void FiberManager::run(Fiber* fiber) {
   }
 }
 
+void FiberManager::run(Fiber::Task* task) {
+  Fiber::Task* prev = task_;
+  task_ = task;
+  task->handle();  // the task may be deleted or resumed elsewhere now
+  task_ = prev;
+}
+
 bool FiberManager::yield() {
   Fiber* fiber = get();
   if (fiber) {
@@ -63,6 +80,13 @@ bool FiberManager::yield() {
   return false;
 }
 
+void FiberManager::setWait(int reason, const char* detail) {
+  Fiber* fiber = get();
+  if (fiber) {
+    fiber->setWait(reason, detail);
+  }
+}
+
 bool FiberManager::exit() {
   Fiber* fiber = get();
   if (fiber) {
@@ -72,9 +96,35 @@ bool FiberManager::exit() {
   return false;
 }
 
+Fiber* FiberManager::create(size_t stackSize,
+                            std::unique_ptr<Fiber::Task> task) {
+  size_t i = StackPool::sizeClass(stackSize);
+  if (i < StackPool::kClassCount && cache_[i]) {
+    Fiber* fiber = cache_[i];
+    cache_[i] = fiber->next_;
+    --cacheSize_;
+    fiber->next_ = nullptr;
+    fiber->reset(std::move(task));
+    return fiber;
+  }
+  return new Fiber(stackSize, std::move(task));
+}
+
+void FiberManager::recycle(Fiber* fiber) {
+  fiber->reset(nullptr);
+  size_t i = StackPool::sizeClass(fiber->stackSize());
+  if (i >= StackPool::kClassCount || cacheSize_ >= FLAGS_fc_cache_size) {
+    delete fiber;
+    return;
+  }
+  fiber->next_ = cache_[i];
+  cache_[i] = fiber;
+  ++cacheSize_;
+}
+
 Fiber::Task* getCurrentFiberTask() {
   Fiber* fiber = FiberManager::get();
-  return fiber ? fiber->task() : nullptr;
+  return fiber ? fiber->task() : FiberManager::task_;
 }
 
 } // namespace rdd
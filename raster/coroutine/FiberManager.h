@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include "raster/Portability.h"
 #include "raster/coroutine/Fiber.h"
+#include "raster/coroutine/StackPool.h"
+
+DECLARE_uint64(fc_cache_size);
 
 namespace rdd {
 
@@ -26,18 +30,35 @@ class FiberManager {
   static Fiber* get();
 
   static void run(Fiber* fiber);
+  // Resume a stackless task on the current thread.
+  static void run(Fiber::Task* task);
   static bool yield();
   static bool exit();
 
+  // Tell what the current fiber is going to wait on, see Fiber::setWait.
+  static void setWait(int reason, const char* detail = "");
+
+  // Take a cached fiber of the stack size class (or allocate one) for the task.
+  static Fiber* create(size_t stackSize, std::unique_ptr<Fiber::Task> task);
+  // Disarm an exited fiber and keep it in the per-thread cache.
+  static void recycle(Fiber* fiber);
+
  private:
+  friend Fiber::Task* getCurrentFiberTask();
+
   FiberManager() {}
 
   FiberManager(const FiberManager&) = delete;
   FiberManager& operator=(const FiberManager&) = delete;
 
   static __thread Fiber* fiber_;
+  static __thread Fiber::Task* task_;  // running stackless task
+
+  static __thread Fiber* cache_[StackPool::kClassCount];
+  static __thread size_t cacheSize_;
 };
 
+// The task of the current fiber, or the running stackless task.
 Fiber::Task* getCurrentFiberTask();
 
 } // namespace rdd
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/coroutine/FiberMutex.h"
+
+namespace rdd {
+
+void FiberMutex::lock() {
+  FiberBaton baton;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (!locked_) {
+      locked_ = true;
+      return;
+    }
+    waiters_.push_back(&baton);
+  }
+  baton.wait("mutex");  // owned on return
+}
+
+bool FiberMutex::try_lock() {
+  acc::SpinLockGuard guard(lock_);
+  if (!locked_) {
+    locked_ = true;
+    return true;
+  }
+  return false;
+}
+
+void FiberMutex::unlock() {
+  FiberBaton* baton;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (waiters_.empty()) {
+      locked_ = false;
+      return;
+    }
+    baton = waiters_.front();
+    waiters_.pop_front();
+  }
+  baton->post();
+}
+
+void FiberSharedMutex::lock() {
+  Waiter waiter;
+  waiter.exclusive = true;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (!writer_ && readers_ == 0 && waiters_.empty()) {
+      writer_ = true;
+      return;
+    }
+    waiters_.push_back(&waiter);
+  }
+  waiter.baton.wait("shared_mutex");
+}
+
+bool FiberSharedMutex::try_lock() {
+  acc::SpinLockGuard guard(lock_);
+  if (!writer_ && readers_ == 0 && waiters_.empty()) {
+    writer_ = true;
+    return true;
+  }
+  return false;
+}
+
+void FiberSharedMutex::unlock() {
+  std::deque<Waiter*> woken;
+  {
+    acc::SpinLockGuard guard(lock_);
+    writer_ = false;
+    wakeWaiters(woken);
+  }
+  for (auto& waiter : woken) {
+    waiter->baton.post();
+  }
+}
+
+void FiberSharedMutex::lock_shared() {
+  Waiter waiter;
+  waiter.exclusive = false;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (!writer_ && waiters_.empty()) {
+      ++readers_;
+      return;
+    }
+    waiters_.push_back(&waiter);
+  }
+  waiter.baton.wait("shared_mutex");
+}
+
+bool FiberSharedMutex::try_lock_shared() {
+  acc::SpinLockGuard guard(lock_);
+  if (!writer_ && waiters_.empty()) {
+    ++readers_;
+    return true;
+  }
+  return false;
+}
+
+void FiberSharedMutex::unlock_shared() {
+  std::deque<Waiter*> woken;
+  {
+    acc::SpinLockGuard guard(lock_);
+    --readers_;
+    wakeWaiters(woken);
+  }
+  for (auto& waiter : woken) {
+    waiter->baton.post();
+  }
+}
+
+void FiberSharedMutex::wakeWaiters(std::deque<Waiter*>& woken) {
+  if (writer_) {
+    return;
+  }
+  while (!waiters_.empty()) {
+    Waiter* waiter = waiters_.front();
+    if (waiter->exclusive) {
+      if (readers_ == 0 && woken.empty()) {
+        writer_ = true;
+        woken.push_back(waiter);
+        waiters_.pop_front();
+      }
+      return;
+    }
+    ++readers_;
+    woken.push_back(waiter);
+    waiters_.pop_front();
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "accelerator/thread/SpinLock.h"
+#include "raster/coroutine/FiberBaton.h"
+
+namespace rdd {
+
+/*
+ * Mutex which parks the fiber instead of blocking the thread.
+ *
+ * Works from plain threads as well (blocks the thread).  Ownership is
+ * handed to the first waiter on unlock, so waiters are served in order.
+ */
+class FiberMutex {
+ public:
+  FiberMutex() {}
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  FiberMutex(const FiberMutex&) = delete;
+  FiberMutex& operator=(const FiberMutex&) = delete;
+
+ private:
+  acc::SpinLock lock_;
+  bool locked_{false};
+  std::deque<FiberBaton*> waiters_;
+};
+
+/*
+ * Shared mutex which parks the fiber instead of blocking the thread.
+ *
+ * New readers queue behind a waiting writer, so writers do not starve.
+ */
+class FiberSharedMutex {
+ public:
+  FiberSharedMutex() {}
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  void lock_shared();
+  bool try_lock_shared();
+  void unlock_shared();
+
+  FiberSharedMutex(const FiberSharedMutex&) = delete;
+  FiberSharedMutex& operator=(const FiberSharedMutex&) = delete;
+
+ private:
+  struct Waiter {
+    FiberBaton baton;
+    bool exclusive;
+  };
+
+  // wake the waiters which can go now, call with lock_ held
+  void wakeWaiters(std::deque<Waiter*>& woken);
+
+  acc::SpinLock lock_;
+  bool writer_{false};
+  size_t readers_{0};
+  std::deque<Waiter*> waiters_;
+};
+
+} // namespace rdd
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/FiberRegistry.h"
+
+#include <algorithm>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+
+namespace rdd {
+
+std::ostream& operator<<(std::ostream& os, const FiberInfo& info) {
+  os << "fc(" << (const void*)info.fiber
+     << ", pool=" << info.poolId
+     << ", " << Fiber::statusName(info.status) << " " << info.statusCost << "us"
+     << ", cost=" << info.cost << "us"
+     << ", stack=" << info.stackSize;
+  if (info.waitReason != Fiber::kWaitNone) {
+    os << ", wait=" << Fiber::waitReasonName(info.waitReason);
+    if (!info.waitDetail.empty()) {
+      os << "(" << info.waitDetail << ")";
+    }
+  }
+  os << ")";
+  return os;
+}
+
+FiberRegistry* FiberRegistry::get() {
+  static FiberRegistry* registry = new FiberRegistry();  // never freed
+  return registry;
+}
+
+void FiberRegistry::add(Fiber* fiber) {
+  std::lock_guard<std::mutex> guard(lock_);
+  fibers_.insert(fiber);
+}
+
+void FiberRegistry::remove(Fiber* fiber) {
+  std::lock_guard<std::mutex> guard(lock_);
+  fibers_.erase(fiber);
+}
+
+std::vector<FiberInfo> FiberRegistry::snapshot() {
+  std::vector<FiberInfo> infos;
+  uint64_t now = acc::timestampNow();
+  std::lock_guard<std::mutex> guard(lock_);
+  infos.reserve(fibers_.size());
+  for (auto& fiber : fibers_) {
+    int poolId = fiber->poolId();
+    if (poolId < 0) {
+      continue;  // cached
+    }
+    FiberInfo info;
+    info.fiber = fiber;
+    info.status = fiber->status();
+    uint64_t t = fiber->statusTime();
+    info.statusCost = now > t ? now - t : 0;
+    t = fiber->starttime();
+    info.cost = now > t ? now - t : 0;
+    info.poolId = poolId;
+    info.stackSize = fiber->stackSize();
+    info.waitReason = fiber->waitReason();
+    if (info.waitReason != Fiber::kWaitNone) {
+      info.waitDetail = fiber->waitDetail();
+    }
+    infos.push_back(std::move(info));
+  }
+  return infos;
+}
+
+void FiberRegistry::dump() {
+  auto infos = snapshot();
+  std::sort(infos.begin(), infos.end(),
+            [](const FiberInfo& a, const FiberInfo& b) {
+    bool x = a.status == Fiber::kBlock;
+    bool y = b.status == Fiber::kBlock;
+    return x != y ? x : a.statusCost > b.statusCost;
+  });
+  size_t blocked = 0;
+  for (auto& info : infos) {
+    if (info.status == Fiber::kBlock) {
+      ++blocked;
+    }
+  }
+  ACCLOG(INFO) << "dump fibers: " << infos.size()
+    << " (" << blocked << " blocked)";
+  for (auto& info : infos) {
+    ACCLOG(INFO) << info;
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "raster/coroutine/Fiber.h"
+
+namespace rdd {
+
+struct FiberInfo {
+  const Fiber* fiber;   // only as id, may be freed
+  int status;
+  uint64_t statusCost;  // us in the status
+  uint64_t cost;        // us since the task started
+  int poolId;
+  size_t stackSize;
+  int waitReason;
+  std::string waitDetail;
+};
+
+std::ostream& operator<<(std::ostream& os, const FiberInfo& info);
+
+/*
+ * Registry of fibers for introspection.
+ *
+ * Fibers are added and removed when allocated and freed (not when taken
+ * from or given back to the cache), the switch path touches only
+ * relaxed atomics of the fiber.  A snapshot lists the fibers with tasks.
+ */
+class FiberRegistry {
+ public:
+  static FiberRegistry* get();
+
+  void add(Fiber* fiber);
+  void remove(Fiber* fiber);
+
+  std::vector<FiberInfo> snapshot();
+
+  // Write the snapshot to log, blocked fibers first by time blocked.
+  // Not async-signal-safe, a signal only wakes a thread to call it.
+  void dump();
+
+ private:
+  std::mutex lock_;
+  std::unordered_set<Fiber*> fibers_;
+};
+
+} // namespace rdd
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/FiberScheduler.h"
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/FiberManager.h"
+
+namespace rdd {
+
+void FiberScheduler::run(Fiber::Task* task) {
+  if (task->stackless) {
+    FiberManager::run(task);
+    return;
+  }
+  Fiber* fiber = task->fiber;
+  if (!fiber) {
+    if (expired(task)) {
+      drop(task);
+      return;
+    }
+    fiber = FiberManager::create(task->stackSize,
+                                 std::unique_ptr<Fiber::Task>(task));
+  }
+  FiberManager::run(fiber);
+}
+
+bool FiberScheduler::expired(const Fiber::Task* task) {
+  return task->deadline > 0 && acc::timestampNow() > task->deadline;
+}
+
+void FiberScheduler::drop(Fiber::Task* task) {
+  // counted, a log per drop would flood under the overload it sheds
+  ACCLOG(V1) << "drop task exceeding deadline by "
+    << acc::timePassed(task->deadline) << "us";
+  ACCMON_CNT("fiber.deadline_drop");
+  discard(task);
+}
+
+void FiberScheduler::discard(Fiber::Task* task) {
+  task->drop();
+  if (task->scheduleCallback) {
+    task->scheduleCallback();
+  }
+  delete task;
+}
+
+void ExecutorScheduler::schedule(Fiber::Task* task) {
+  executor_->add([task]() { run(task); });
+}
+
+} // namespace rdd
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "accelerator/concurrency/CPUThreadPoolExecutor.h"
+#include "raster/coroutine/Fiber.h"
+
+namespace rdd {
+
+/*
+ * Runs fiber tasks of a pool.
+ *
+ * A scheduled task without fiber gets one (of task->stackSize) on the
+ * thread which runs it, a task with fiber is resumed.  A task without
+ * fiber whose deadline has passed is dropped instead.  A stackless task
+ * is resumed by its handle().
+ */
+class FiberScheduler {
+ public:
+  virtual ~FiberScheduler() {}
+
+  virtual void schedule(Fiber::Task* task) = 0;
+
+  virtual std::string name() const = 0;
+
+  static bool expired(const Fiber::Task* task);
+  static void drop(Fiber::Task* task);
+  // Drop a task not started: drop(), scheduleCallback, then delete.
+  static void discard(Fiber::Task* task);
+
+ protected:
+  static void run(Fiber::Task* task);
+};
+
+class ExecutorScheduler : public FiberScheduler {
+ public:
+  ExecutorScheduler(std::shared_ptr<acc::CPUThreadPoolExecutor> executor)
+    : executor_(executor) {}
+
+  void schedule(Fiber::Task* task) override;
+
+  std::string name() const override {
+    return executor_->getThreadFactory()->namePrefix();
+  }
+
+ private:
+  std::shared_ptr<acc::CPUThreadPoolExecutor> executor_;
+};
+
+} // namespace rdd
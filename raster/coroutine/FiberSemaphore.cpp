@@ -0,0 +1,56 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/coroutine/FiberSemaphore.h"
+
+namespace rdd {
+
+void FiberSemaphore::wait() {
+  FiberBaton baton;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (count_ > 0) {
+      --count_;
+      return;
+    }
+    waiters_.push_back(&baton);
+  }
+  baton.wait("semaphore");  // the count is handed over
+}
+
+bool FiberSemaphore::try_wait() {
+  acc::SpinLockGuard guard(lock_);
+  if (count_ > 0) {
+    --count_;
+    return true;
+  }
+  return false;
+}
+
+void FiberSemaphore::post() {
+  FiberBaton* baton = nullptr;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (waiters_.empty()) {
+      ++count_;
+      return;
+    }
+    baton = waiters_.front();
+    waiters_.pop_front();
+  }
+  baton->post();
+}
+
+} // namespace rdd
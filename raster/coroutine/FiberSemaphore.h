@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "accelerator/thread/SpinLock.h"
+#include "raster/coroutine/FiberBaton.h"
+
+namespace rdd {
+
+/*
+ * Counting semaphore which parks the fiber instead of blocking the
+ * thread.  Waiters are served in order.
+ */
+class FiberSemaphore {
+ public:
+  explicit FiberSemaphore(size_t count = 0) : count_(count) {}
+
+  void wait();
+  bool try_wait();
+  void post();
+
+  size_t count() const { return count_; }
+
+  FiberSemaphore(const FiberSemaphore&) = delete;
+  FiberSemaphore& operator=(const FiberSemaphore&) = delete;
+
+ private:
+  acc::SpinLock lock_;
+  size_t count_;
+  std::deque<FiberBaton*> waiters_;
+};
+
+} // namespace rdd
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#include "accelerator/thread/SpinLock.h"
+
+namespace rdd {
+
+/*
+ * Per-thread free list of T sized blocks.
+ *
+ * Objects are often created on one thread (IO) and destroyed on another
+ * (CPU), so a thread holding more than 2 * kBatch free blocks moves a
+ * batch of kBatch to a shared depot, and a thread running out of blocks
+ * takes a batch back.  The depot lock is taken once per batch.
+ *
+ * Use it from class-specific operator new/delete:
+ *
+ *   static void* operator new(size_t size) {
+ *     return FreeList<T>::allocate(size);
+ *   }
+ *   static void operator delete(void* p, size_t size) {
+ *     FreeList<T>::deallocate(p, size);
+ *   }
+ */
+template <class T>
+class FreeList {
+ public:
+  static constexpr size_t kBatch = 64;
+  static constexpr size_t kMaxBatches = 64;
+
+  static void* allocate(size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);  // derived class
+    }
+    if (!local_.head) {
+      refill();
+    }
+    if (local_.head) {
+      Node* node = local_.head;
+      local_.head = node->next;
+      --local_.size;
+      return node;
+    }
+    return ::operator new(size);
+  }
+
+  static void deallocate(void* p, size_t size) {
+    if (size != sizeof(T)) {
+      ::operator delete(p);
+      return;
+    }
+    Node* node = reinterpret_cast<Node*>(p);
+    node->next = local_.head;
+    local_.head = node;
+    if (++local_.size >= 2 * kBatch) {
+      flush();
+    }
+  }
+
+ private:
+  struct Node {
+    Node* next;
+    Node* nextBatch;
+  };
+
+  static_assert(sizeof(T) >= sizeof(Node), "T is too small");
+
+  struct Local {
+    Node* head;
+    size_t size;
+  };
+
+  static void refill() {
+    Node* batch;
+    {
+      acc::SpinLockGuard guard(lock_);
+      batch = depot_;
+      if (!batch) {
+        return;
+      }
+      depot_ = batch->nextBatch;
+      --depotSize_;
+    }
+    local_.head = batch;
+    local_.size = kBatch;
+  }
+
+  static void flush() {
+    Node* batch = local_.head;
+    Node* tail = batch;
+    for (size_t i = 1; i < kBatch; ++i) {
+      tail = tail->next;
+    }
+    local_.head = tail->next;
+    local_.size -= kBatch;
+    tail->next = nullptr;
+    {
+      acc::SpinLockGuard guard(lock_);
+      if (depotSize_ < kMaxBatches) {
+        batch->nextBatch = depot_;
+        depot_ = batch;
+        ++depotSize_;
+        return;
+      }
+    }
+    while (batch) {
+      Node* next = batch->next;
+      ::operator delete(batch);
+      batch = next;
+    }
+  }
+
+  static __thread Local local_;
+
+  static acc::SpinLock lock_;
+  static Node* depot_;
+  static size_t depotSize_;
+};
+
+template <class T>
+constexpr size_t FreeList<T>::kBatch;
+template <class T>
+constexpr size_t FreeList<T>::kMaxBatches;
+
+template <class T>
+__thread typename FreeList<T>::Local FreeList<T>::local_;
+
+template <class T>
+acc::SpinLock FreeList<T>::lock_;
+template <class T>
+typename FreeList<T>::Node* FreeList<T>::depot_ = nullptr;
+template <class T>
+size_t FreeList<T>::depotSize_ = 0;
+
+} // namespace rdd
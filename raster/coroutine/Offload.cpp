@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/Offload.h"
+
+#include "accelerator/Logging.h"
+#include "accelerator/Singleton.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/Fiber.h"
+
+namespace rdd {
+
+OffloadPool::~OffloadPool() {
+  stop();
+}
+
+void OffloadPool::configure(size_t threadCount,
+                            size_t maxQueue,
+                            uint64_t queueTimeout) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!threads_.empty()) {
+    ACCLOG(WARN) << "offload pool started, ignore config";
+    return;
+  }
+  maxQueue_ = maxQueue;
+  queueTimeout_ = queueTimeout;
+  start(threadCount);
+}
+
+void OffloadPool::start(size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  ACCLOG(INFO) << "offload pool start " << threadCount << " threads";
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads_.emplace_back([this]() { loop(); });
+  }
+}
+
+bool OffloadPool::add(Job&& job) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (stop_) {
+    return false;
+  }
+  if (threads_.empty()) {
+    start(4);
+  }
+  if (maxQueue_ > 0 && queue_.size() >= maxQueue_) {
+    ACCMON_CNT("offload.reject");
+    return false;
+  }
+  queue_.push_back({std::move(job), acc::timestampNow()});
+  ACCMON_AVG("offload.queue_size", queue_.size());
+  cond_.notify_one();
+  return true;
+}
+
+void OffloadPool::stop() {
+  std::deque<Item> queue;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (stop_) {
+      return;
+    }
+    stop_ = true;
+    queue.swap(queue_);
+    cond_.notify_all();
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  for (auto& item : queue) {
+    item.job(false);
+  }
+}
+
+size_t OffloadPool::queueSize() {
+  std::lock_guard<std::mutex> guard(lock_);
+  return queue_.size();
+}
+
+void OffloadPool::loop() {
+  while (true) {
+    Item item;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        break;
+      }
+      item = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    uint64_t wait = acc::timePassed(item.ctime);
+    ACCMON_AVG("offload.queue_wait", wait);
+    if (queueTimeout_ > 0 && wait > queueTimeout_) {
+      ACCMON_CNT("offload.queue_timeout");
+      item.job(false);
+    } else {
+      item.job(true);
+    }
+  }
+}
+
+namespace detail {
+
+bool offload(OffloadPool::Job&& job, FiberBaton& baton) {
+  if (!acc::Singleton<OffloadPool>::get()->add(std::move(job))) {
+    return false;
+  }
+  baton.wait("offload", Fiber::kWaitOffload);
+  return true;
+}
+
+} // namespace detail
+
+} // namespace rdd
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "raster/coroutine/FiberBaton.h"
+
+namespace rdd {
+
+class OffloadException : public std::runtime_error {
+ public:
+  explicit OffloadException(const std::string& what)
+    : std::runtime_error(what) {}
+};
+
+/*
+ * Bounded thread pool for blocking calls (file io, getaddrinfo, curl,
+ * legacy sdk) made from fibers, so they do not stall a fiber pool thread.
+ *
+ * A job is called with true to run, or with false if it is dropped:
+ * waited longer than queueTimeout (us, 0 for no limit) in the queue, or
+ * the pool is stopped.  maxQueue 0 is unbounded.
+ */
+class OffloadPool {
+ public:
+  typedef std::function<void(bool)> Job;
+
+  OffloadPool() {}
+  ~OffloadPool();
+
+  // Start threads, only the first call (or the first add) works.
+  void configure(size_t threadCount, size_t maxQueue, uint64_t queueTimeout);
+
+  // Return false if the queue is full.
+  bool add(Job&& job);
+
+  void stop();
+
+  size_t queueSize();
+
+ private:
+  struct Item {
+    Job job;
+    uint64_t ctime;
+  };
+
+  void start(size_t threadCount);
+  void loop();
+
+  std::vector<std::thread> threads_;
+  size_t maxQueue_{0};
+  uint64_t queueTimeout_{0};
+
+  std::mutex lock_;
+  std::condition_variable cond_;
+  std::deque<Item> queue_;
+  bool stop_{false};
+};
+
+namespace detail {
+
+template <class T>
+struct OffloadResult {
+  template <class F>
+  void set(F& fn) { value.reset(new T(fn())); }
+
+  T get() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return std::move(*value);
+  }
+
+  std::unique_ptr<T> value;
+  std::exception_ptr error;
+};
+
+template <>
+struct OffloadResult<void> {
+  template <class F>
+  void set(F& fn) { fn(); }
+
+  void get() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  std::exception_ptr error;
+};
+
+bool offload(OffloadPool::Job&& job, FiberBaton& baton);
+
+} // namespace detail
+
+/*
+ * Run fn on the offload pool and park the current fiber (or block the
+ * current thread) until it is done.  Return the result of fn or rethrow
+ * its exception; throw OffloadException if the pool rejects or drops it.
+ *
+ * The fiber is resumed by its pool's scheduler, never inline on the
+ * offload thread which posts it, even for an io_run one (see IoScope).
+ */
+template <class F>
+auto offload(F&& fn) -> typename std::result_of<F()>::type {
+  typedef typename std::result_of<F()>::type T;
+  detail::OffloadResult<T> result;
+  FiberBaton baton;
+  // result, baton and fn live on the waiting stack until post()
+  bool added = detail::offload([&](bool run) {
+    if (run) {
+      try {
+        result.set(fn);
+      } catch (...) {
+        result.error = std::current_exception();
+      }
+    } else {
+      result.error = std::make_exception_ptr(
+          OffloadException("offload queue timeout"));
+    }
+    // to the fiber's pool: no IoScope on the offload thread
+    baton.post();
+  }, baton);
+  if (!added) {
+    throw OffloadException("offload queue full");
+  }
+  return result.get();
+}
+
+} // namespace rdd
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/StackPool.h"
+
+#include <algorithm>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "accelerator/Logging.h"
+#include "accelerator/thread/ThreadUtil.h"
+
+DEFINE_uint64(fc_stack_hot, 64,
+              "# of released fiber stacks kept resident per thread.");
+
+DEFINE_uint64(fc_stack_cache, 1024,
+              "# of released fiber stacks cached per thread.");
+
+DEFINE_uint64(fc_stack_probe, 1024,
+              "Measure stack usage of 1 in N fiber stacks (0 to disable).");
+
+namespace rdd {
+
+namespace {
+
+const unsigned char kPaint = 0xa5;
+
+// painted bytes above the guard page, the pages of the band are committed
+const size_t kPaintBand = 64 * 1024;
+
+}
+
+constexpr size_t StackPool::kMinClassShift;
+constexpr size_t StackPool::kClassCount;
+
+StackPool* StackPool::get() {
+  static acc::ThreadLocal<StackPool> pool;
+  return pool.get();
+}
+
+size_t StackPool::roundSize(size_t size) {
+  size_t i = sizeClass(size);
+  if (i < kClassCount) {
+    return size_t(1) << (kMinClassShift + i);
+  }
+  size_t page = pageSize();
+  return (size + page - 1) / page * page;
+}
+
+size_t StackPool::sizeClass(size_t size) {
+  size_t i = 0;
+  while (i < kClassCount && (size_t(1) << (kMinClassShift + i)) < size) {
+    ++i;
+  }
+  return i;
+}
+
+StackPool::~StackPool() {
+  for (size_t i = 0; i < kClassCount; ++i) {
+    size_t size = size_t(1) << (kMinClassShift + i);
+    for (auto limit : caches_[i].hot) {
+      unmap(limit, size);
+    }
+    for (auto limit : caches_[i].cold) {
+      unmap(limit, size);
+    }
+  }
+}
+
+unsigned char* StackPool::allocate(size_t size) {
+  size_t i = sizeClass(size);
+  if (i < kClassCount) {
+    Cache& cache = caches_[i];
+    if (!cache.hot.empty()) {
+      unsigned char* limit = cache.hot.back();
+      cache.hot.pop_back();
+      return limit;
+    }
+    if (!cache.cold.empty()) {
+      unsigned char* limit = cache.cold.back();
+      cache.cold.pop_back();
+      return limit;
+    }
+  }
+  return map(size);
+}
+
+void StackPool::deallocate(unsigned char* limit, size_t size) {
+  size_t i = sizeClass(size);
+  if (i >= kClassCount) {
+    unmap(limit, size);
+    return;
+  }
+  Cache& cache = caches_[i];
+  if (cache.hot.size() < FLAGS_fc_stack_hot) {
+    cache.hot.push_back(limit);
+    return;
+  }
+  if (cache.cold.size() < FLAGS_fc_stack_cache) {
+    // drop the resident pages, the mapping (and guard page) is kept
+    if (::madvise(limit, size, MADV_DONTNEED) == -1) {
+      ACCPLOG(WARN) << "madvise fiber stack failed";
+    }
+    cache.cold.push_back(limit);
+    return;
+  }
+  unmap(limit, size);
+}
+
+bool StackPool::paint(unsigned char* limit, size_t size) {
+  if (FLAGS_fc_stack_probe == 0 ||
+      ++probeCount_ < FLAGS_fc_stack_probe) {
+    return false;
+  }
+  probeCount_ = 0;
+  memset(limit, kPaint, std::min(size, kPaintBand));
+  return true;
+}
+
+bool StackPool::highWaterMark(unsigned char* limit, size_t size,
+                              size_t& used) {
+  // stack grows down from limit + size
+  size_t band = std::min(size, kPaintBand);
+  size_t i = 0;
+  while (i < band && limit[i] == kPaint) {
+    ++i;
+  }
+  if (i == band && band < size) {
+    return false;  // never reached the band
+  }
+  used = size - i;
+  return true;
+}
+
+size_t StackPool::hotCount() const {
+  size_t n = 0;
+  for (auto& cache : caches_) {
+    n += cache.hot.size();
+  }
+  return n;
+}
+
+size_t StackPool::coldCount() const {
+  size_t n = 0;
+  for (auto& cache : caches_) {
+    n += cache.cold.size();
+  }
+  return n;
+}
+
+size_t StackPool::pageSize() {
+  static const size_t size = ::sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+unsigned char* StackPool::map(size_t size) {
+  size_t guard = pageSize();
+  void* p = ::mmap(nullptr, size + guard,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                   -1, 0);
+  if (p == MAP_FAILED) {
+    ACCPLOG(ERROR) << "mmap fiber stack failed, size=" << size;
+    throw std::bad_alloc();
+  }
+  // stack grows down, protect the lowest page as guard
+  if (::mprotect(p, guard, PROT_NONE) == -1) {
+    ACCPLOG(WARN) << "mprotect fiber stack guard page failed";
+  }
+  return (unsigned char*)p + guard;
+}
+
+void StackPool::unmap(unsigned char* limit, size_t size) {
+  size_t guard = pageSize();
+  if (::munmap(limit - guard, size + guard) == -1) {
+    ACCPLOG(ERROR) << "munmap fiber stack failed";
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "raster/Portability.h"
+
+DECLARE_uint64(fc_stack_hot);
+DECLARE_uint64(fc_stack_cache);
+DECLARE_uint64(fc_stack_probe);
+
+namespace rdd {
+
+/*
+ * Per-thread pool of fiber stacks.
+ *
+ * Stack sizes are rounded up to a power of two size class, from 16KB to
+ * 8MB, and each class is cached separately.  Each stack is mmap'd with a
+ * PROT_NONE guard page below its limit, so an overflow faults instead of
+ * corrupting the neighbouring memory.  Released stacks are kept for
+ * reuse: the first FLAGS_fc_stack_hot ones stay resident, the rest are
+ * madvise(MADV_DONTNEED)'d before caching, and stacks beyond
+ * FLAGS_fc_stack_cache are unmapped (limits are per class).
+ *
+ * One of every FLAGS_fc_stack_probe stacks is painted when handed out, so
+ * its high-water mark can be measured when it comes back, reported per
+ * service as fiber.stack_used-<channel id>.  Only a bounded band above
+ * the guard page is painted, as painting commits the pages: a large
+ * stack is measured when its use comes that close to overflow, and
+ * counted in fiber.stack_shallow-<channel id> otherwise.
+ */
+class StackPool {
+ public:
+  static constexpr size_t kMinClassShift = 14;  // 16KB
+  static constexpr size_t kClassCount = 10;     // up to 8MB
+
+  static StackPool* get();
+
+  // Round size up to its size class (sizes beyond the classes are
+  // rounded to pages and never cached).
+  static size_t roundSize(size_t size);
+  static size_t sizeClass(size_t size);
+
+  StackPool() {}
+  ~StackPool();
+
+  // size must be rounded by roundSize()
+  unsigned char* allocate(size_t size);
+  void deallocate(unsigned char* limit, size_t size);
+
+  // Paint the stack if it is sampled, return whether it is painted.
+  bool paint(unsigned char* limit, size_t size);
+  // Bytes used by a painted stack, false if its use never reached the
+  // painted band.
+  static bool highWaterMark(unsigned char* limit, size_t size,
+                            size_t& used);
+
+  size_t hotCount() const;
+  size_t coldCount() const;
+
+  StackPool(const StackPool&) = delete;
+  StackPool& operator=(const StackPool&) = delete;
+
+ private:
+  static size_t pageSize();
+
+  static unsigned char* map(size_t size);
+  static void unmap(unsigned char* limit, size_t size);
+
+  struct Cache {
+    std::vector<unsigned char*> hot;
+    std::vector<unsigned char*> cold;
+  };
+
+  std::array<Cache, kClassCount> caches_;
+  size_t probeCount_{0};
+};
+
+} // namespace rdd
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rdd {
+
+/*
+ * Bounded Chase-Lev deque of pointers.
+ *
+ * The owner thread pushes and pops at the bottom, other threads steal
+ * from the top.  push fails when the deque is full.
+ */
+template <class T, size_t Capacity = 1024>
+class WorkStealingDeque {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of 2");
+
+ public:
+  WorkStealingDeque() {
+    for (auto& p : buffer_) {
+      p.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // owner only
+  bool push(T* p) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= int64_t(Capacity)) {
+      return false;
+    }
+    buffer_[b & kMask].store(p, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // owner only
+  T* pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* p = buffer_[b & kMask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // last one, race with thieves
+      if (!top_.compare_exchange_strong(t, t + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        p = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return p;
+  }
+
+  // any thread
+  T* steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    T* p = buffer_[t & kMask].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return p;
+  }
+
+  // approximate
+  bool empty() const {
+    return bottom_.load(std::memory_order_relaxed) <=
+      top_.load(std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+ private:
+  static constexpr int64_t kMask = Capacity - 1;
+  static constexpr size_t kCacheLine = 64;
+
+  // padded by hand: over-aligned types are not honored by new in C++11,
+  // so keep top_ and bottom_ a line apart from each other and neighbors
+  char pad0_[kCacheLine];
+  std::atomic<int64_t> top_{0};
+  char pad1_[kCacheLine - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_{0};
+  char pad2_[kCacheLine - sizeof(std::atomic<int64_t>)];
+  std::array<std::atomic<T*>, Capacity> buffer_;
+};
+
+} // namespace rdd
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/coroutine/WorkStealingScheduler.h"
+
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+
+namespace rdd {
+
+constexpr size_t WorkStealingScheduler::kMaxLifoRuns;
+constexpr size_t WorkStealingScheduler::kInjectBatch;
+constexpr size_t WorkStealingScheduler::kInjectInterval;
+constexpr size_t WorkStealingScheduler::kReportInterval;
+constexpr uint64_t WorkStealingScheduler::kMailWait;
+
+__thread WorkStealingScheduler* WorkStealingScheduler::current_ = nullptr;
+__thread WorkStealingScheduler::Worker* WorkStealingScheduler::worker_ =
+  nullptr;
+
+WorkStealingScheduler::WorkStealingScheduler(
+    size_t threadCount,
+    std::shared_ptr<acc::ThreadFactory> threadFactory,
+    bool bindCpu)
+  : threadFactory_(threadFactory), bindCpu_(bindCpu) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.emplace_back(new Worker());
+    workers_.back()->seed = i * 2654435761u + 1;
+    workers_.back()->index = i;
+  }
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads_.push_back(threadFactory_->newThread([this, i]() { loop(i); }));
+  }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+  stop();
+}
+
+void WorkStealingScheduler::stop() {
+  if (stop_.exchange(true)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(parkLock_);
+    for (auto& worker : workers_) {
+      worker->cond.notify_one();
+    }
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t WorkStealingScheduler::localResumes() const {
+  size_t n = 0;
+  for (auto& worker : workers_) {
+    n += worker->localResumes.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+size_t WorkStealingScheduler::remoteResumes() const {
+  size_t n = 0;
+  for (auto& worker : workers_) {
+    n += worker->remoteResumes.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+void WorkStealingScheduler::schedule(Fiber::Task* task) {
+  int last = task->fiber ? task->lastThread : -1;
+  if (last >= 0 && size_t(last) < workers_.size() &&
+      (current_ != this || worker_->index != last)) {
+    // back to the worker with its stack in cache
+    Worker* worker = workers_[last].get();
+    mail(worker, task);
+    wake(worker);
+    if (!worker->parked.load(std::memory_order_relaxed)) {
+      // busy, let an idle worker pick it up if it waits too long
+      notify();
+    }
+    return;
+  } else if (current_ != this) {
+    inject(task);
+  } else {
+    Worker* worker = worker_;
+    if (task->fiber) {
+      // woken fiber runs next on this worker
+      std::swap(worker->lifo, task);
+    }
+    if (task && !worker->deque.push(task)) {
+      inject(task);
+    }
+  }
+  notify();
+}
+
+void WorkStealingScheduler::loop(size_t i) {
+  current_ = this;
+  worker_ = workers_[i].get();
+  if (bindCpu_) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)) {
+      ACCLOG(WARN) << name() << i << " bind cpu failed";
+    }
+  }
+  while (!stop_.load(std::memory_order_relaxed)) {
+    Fiber::Task* task = next(worker_);
+    if (task) {
+      runTask(worker_, task);
+    } else {
+      park(worker_);
+    }
+  }
+  current_ = nullptr;
+  worker_ = nullptr;
+}
+
+void WorkStealingScheduler::runTask(Worker* worker, Fiber::Task* task) {
+  if (task->fiber) {
+    size_t local = worker->localResumes.load(std::memory_order_relaxed);
+    size_t remote = worker->remoteResumes.load(std::memory_order_relaxed);
+    if (task->lastThread == worker->index) {
+      worker->localResumes.store(++local, std::memory_order_relaxed);
+    } else {
+      worker->remoteResumes.store(++remote, std::memory_order_relaxed);
+    }
+    if ((local + remote) % kReportInterval == 0) {
+      ACCMON_AVG("fiber.local_resume-" + name(),
+                 local * 100 / (local + remote));
+    }
+  }
+  task->lastThread = worker->index;
+  worker->starved = false;
+  run(task);
+}
+
+Fiber::Task* WorkStealingScheduler::next(Worker* worker) {
+  Fiber::Task* task = worker->lifo;
+  if (task) {
+    worker->lifo = nullptr;
+    if (worker->lifoRuns++ < kMaxLifoRuns) {
+      return task;
+    }
+    worker->lifoRuns = 0;
+    // let the queued tasks go first: it stays local, the oldest runs
+    if (worker->deque.push(task)) {
+      task = worker->deque.steal();
+      if (task) {
+        return task;
+      }
+    } else {
+      inject(task);
+    }
+  }
+  worker->lifoRuns = 0;
+  task = takeMail(worker);
+  if (task) {
+    return task;
+  }
+  if (++worker->tick % kInjectInterval == 0) {
+    task = takeInjected(worker);
+    if (task) {
+      return task;
+    }
+  }
+  task = worker->deque.pop();
+  if (!task) {
+    task = takeInjected(worker);
+  }
+  if (!task) {
+    task = steal(worker);
+  }
+  return task;
+}
+
+Fiber::Task* WorkStealingScheduler::takeInjected(Worker* worker) {
+  if (injectedSize_.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(injectLock_);
+  if (injected_.empty()) {
+    return nullptr;
+  }
+  Fiber::Task* task = injected_.front();
+  injected_.pop_front();
+  // take a fair share for the local deque
+  size_t n = std::min(kInjectBatch, injected_.size() / workers_.size());
+  while (n-- > 0 && worker->deque.push(injected_.front())) {
+    injected_.pop_front();
+  }
+  injectedSize_.store(injected_.size(), std::memory_order_release);
+  return task;
+}
+
+Fiber::Task* WorkStealingScheduler::takeMail(Worker* worker) {
+  if (worker->mailSize.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(worker->mailLock);
+  if (worker->mailbox.empty()) {
+    return nullptr;
+  }
+  Fiber::Task* task = worker->mailbox.front().task;
+  worker->mailbox.pop_front();
+  if (!worker->mailbox.empty()) {
+    worker->mailTime.store(worker->mailbox.front().time,
+                           std::memory_order_relaxed);
+  }
+  worker->mailSize.store(worker->mailbox.size(), std::memory_order_release);
+  return task;
+}
+
+Fiber::Task* WorkStealingScheduler::steal(Worker* worker) {
+  size_t n = workers_.size();
+  worker->seed ^= worker->seed << 13;
+  worker->seed ^= worker->seed >> 17;
+  worker->seed ^= worker->seed << 5;
+  size_t start = worker->seed % n;
+  for (size_t i = 0; i < n; ++i) {
+    Worker* victim = workers_[(start + i) % n].get();
+    if (victim != worker) {
+      Fiber::Task* task = victim->deque.steal();
+      if (task) {
+        return task;
+      }
+    }
+  }
+  // a busy worker's resumed fibers, better cold than late
+  uint64_t now = 0;
+  for (size_t i = 0; i < n; ++i) {
+    Worker* victim = workers_[(start + i) % n].get();
+    if (victim == worker ||
+        victim->mailSize.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    if (now == 0) {
+      now = acc::timestampNow();
+    }
+    if (canTakeMail(worker, victim, now)) {
+      Fiber::Task* task = takeMail(victim);
+      if (task) {
+        return task;
+      }
+    }
+  }
+  return nullptr;
+}
+
+bool WorkStealingScheduler::canTakeMail(
+    Worker* worker, Worker* victim, uint64_t now) const {
+  if (victim->parked.load(std::memory_order_seq_cst)) {
+    return false;  // it is being woken for its mail
+  }
+  return worker->starved ||
+    victim->mailSize.load(std::memory_order_relaxed) > 1 ||
+    victim->mailTime.load(std::memory_order_relaxed) + kMailWait <= now;
+}
+
+void WorkStealingScheduler::mail(Worker* worker, Fiber::Task* task) {
+  uint64_t now = acc::timestampNow();
+  std::lock_guard<std::mutex> guard(worker->mailLock);
+  if (worker->mailbox.empty()) {
+    worker->mailTime.store(now, std::memory_order_relaxed);
+  }
+  worker->mailbox.push_back({task, now});
+  worker->mailSize.store(worker->mailbox.size(), std::memory_order_release);
+}
+
+void WorkStealingScheduler::inject(Fiber::Task* task) {
+  std::lock_guard<std::mutex> guard(injectLock_);
+  injected_.push_back(task);
+  injectedSize_.store(injected_.size(), std::memory_order_release);
+}
+
+void WorkStealingScheduler::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> guard(parkLock_);
+    for (auto& worker : workers_) {
+      if (worker->parked.load(std::memory_order_relaxed)) {
+        worker->cond.notify_one();
+        break;
+      }
+    }
+  }
+}
+
+void WorkStealingScheduler::wake(Worker* worker) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (worker->parked.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> guard(parkLock_);
+    worker->cond.notify_one();
+  }
+}
+
+void WorkStealingScheduler::park(Worker* worker) {
+  std::unique_lock<std::mutex> lock(parkLock_);
+  sleepers_.fetch_add(1, std::memory_order_seq_cst);
+  worker->parked.store(true, std::memory_order_seq_cst);
+  worker->starved = false;
+  if (worker->mailSize.load(std::memory_order_seq_cst) == 0 &&
+      !hasWork() && !stop_.load()) {
+    if (hasMail(worker)) {
+      // come back for the mail of a busy worker once it waited enough
+      worker->cond.wait_for(lock, std::chrono::microseconds(kMailWait));
+    } else {
+      // timed, in case of a missed notify
+      worker->starved = worker->cond.wait_for(
+          lock, std::chrono::milliseconds(10)) == std::cv_status::timeout;
+    }
+  }
+  worker->parked.store(false, std::memory_order_relaxed);
+  sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool WorkStealingScheduler::hasWork() const {
+  if (injectedSize_.load(std::memory_order_acquire) > 0) {
+    return true;
+  }
+  for (auto& worker : workers_) {
+    if (!worker->deque.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingScheduler::hasMail(Worker* worker) const {
+  for (auto& victim : workers_) {
+    if (victim.get() != worker &&
+        !victim->parked.load(std::memory_order_relaxed) &&
+        victim->mailSize.load(std::memory_order_acquire) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace rdd
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "raster/coroutine/FiberScheduler.h"
+#include "raster/coroutine/WorkStealingDeque.h"
+
+namespace rdd {
+
+/*
+ * Work-stealing fiber scheduler.
+ *
+ * Each worker owns a lock-free deque and a LIFO slot.  A task woken by a
+ * fiber on a worker goes to that worker's LIFO slot and runs next, other
+ * tasks scheduled on a worker go to its deque.  Tasks from outside the
+ * pool (IO threads) go to a shared injection queue.  An idle worker takes
+ * a batch from the injection queue, then steals from random workers
+ * before parking.
+ *
+ * A resumed fiber goes back to the worker it last ran on (where its stack
+ * is hot in cache) through the worker's mailbox.  If that worker is busy
+ * an idle one is woken too, which takes the mail once it backs up or has
+ * waited kMailWait, so a resumed fiber is never late for more than that.
+ * With bindCpu worker i is pinned to cpu i.
+ */
+class WorkStealingScheduler : public FiberScheduler {
+ public:
+  WorkStealingScheduler(size_t threadCount,
+                        std::shared_ptr<acc::ThreadFactory> threadFactory,
+                        bool bindCpu = false);
+
+  ~WorkStealingScheduler() override;
+
+  void schedule(Fiber::Task* task) override;
+
+  std::string name() const override {
+    return threadFactory_->namePrefix();
+  }
+
+  void stop();
+
+  // # of resumed fibers run on their last worker, and on another one.
+  size_t localResumes() const;
+  size_t remoteResumes() const;
+
+ private:
+  static constexpr size_t kMaxLifoRuns = 3;
+  static constexpr size_t kInjectBatch = 32;
+  // check the injection queue first every N runs, or it may starve
+  static constexpr size_t kInjectInterval = 61;
+  // report the local resume ratio every N resumes of a worker
+  static constexpr size_t kReportInterval = 4096;
+  // us a mail waits for its busy worker before others may take it
+  static constexpr uint64_t kMailWait = 50;
+
+  struct Mail {
+    Fiber::Task* task;
+    uint64_t time;
+  };
+
+  struct Worker {
+    WorkStealingDeque<Fiber::Task> deque;
+    Fiber::Task* lifo{nullptr};
+    size_t lifoRuns{0};
+    size_t tick{0};
+    uint32_t seed;
+    int index;
+
+    std::mutex mailLock;
+    std::deque<Mail> mailbox;  // resumed fibers of this worker
+    std::atomic<size_t> mailSize{0};
+    std::atomic<uint64_t> mailTime{0};  // of the oldest mail
+    std::atomic<bool> parked{false};
+    std::condition_variable cond;
+    bool starved{false};  // parked until timeout last time
+
+    // written by the owner only
+    std::atomic<size_t> localResumes{0};
+    std::atomic<size_t> remoteResumes{0};
+  };
+
+  void loop(size_t i);
+  Fiber::Task* next(Worker* worker);
+  Fiber::Task* takeInjected(Worker* worker);
+  Fiber::Task* takeMail(Worker* worker);
+  Fiber::Task* steal(Worker* worker);
+  bool canTakeMail(Worker* worker, Worker* victim, uint64_t now) const;
+  void inject(Fiber::Task* task);
+  void mail(Worker* worker, Fiber::Task* task);
+  void runTask(Worker* worker, Fiber::Task* task);
+  void notify();
+  void wake(Worker* worker);
+  void park(Worker* worker);
+  bool hasWork() const;
+  bool hasMail(Worker* worker) const;
+
+  static __thread WorkStealingScheduler* current_;
+  static __thread Worker* worker_;
+
+  std::shared_ptr<acc::ThreadFactory> threadFactory_;
+  bool bindCpu_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex injectLock_;
+  std::deque<Fiber::Task*> injected_;
+  std::atomic<size_t> injectedSize_{0};
+
+  std::mutex parkLock_;
+  std::atomic<size_t> sleepers_{0};
+
+  std::atomic<bool> stop_{false};
+};
+
+} // namespace rdd
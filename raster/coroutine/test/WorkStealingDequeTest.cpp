@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "raster/coroutine/WorkStealingDeque.h"
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace rdd;
+
+TEST(WorkStealingDeque, lifoAndFifo) {
+  WorkStealingDeque<int, 8> deque;
+  int v[3] = {0, 1, 2};
+  EXPECT_TRUE(deque.empty());
+  EXPECT_EQ(nullptr, deque.pop());
+  EXPECT_EQ(nullptr, deque.steal());
+  for (auto& i : v) {
+    EXPECT_TRUE(deque.push(&i));
+  }
+  EXPECT_FALSE(deque.empty());
+  // the owner takes the newest, thieves the oldest
+  EXPECT_EQ(&v[2], deque.pop());
+  EXPECT_EQ(&v[0], deque.steal());
+  EXPECT_EQ(&v[1], deque.pop());
+  EXPECT_EQ(nullptr, deque.pop());
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, bounded) {
+  WorkStealingDeque<int, 4> deque;
+  int v[5];
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(deque.push(&v[i]));
+  }
+  EXPECT_FALSE(deque.push(&v[4]));
+  EXPECT_EQ(&v[0], deque.steal());
+  // wraps around the buffer
+  EXPECT_TRUE(deque.push(&v[4]));
+  EXPECT_EQ(&v[4], deque.pop());
+  EXPECT_EQ(&v[1], deque.steal());
+}
+
+TEST(WorkStealingDeque, concurrentSteal) {
+  const int kItems = 100000;
+  const int kThieves = 4;
+  WorkStealingDeque<int, 256> deque;
+  std::vector<int> items(kItems, 0);
+  std::vector<std::atomic<int>> taken(kItems);
+  for (auto& t : taken) {
+    t.store(0);
+  }
+  std::atomic<bool> done{false};
+  auto take = [&](int* p) {
+    if (p) {
+      taken[p - items.data()].fetch_add(1);
+    }
+  };
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThieves; ++i) {
+    thieves.emplace_back([&]() {
+      while (!done.load()) {
+        take(deque.steal());
+      }
+    });
+  }
+  for (int i = 0; i < kItems; ++i) {
+    while (!deque.push(&items[i])) {
+      take(deque.pop());
+    }
+    if (i % 3 == 0) {
+      take(deque.pop());
+    }
+  }
+  while (!deque.empty()) {
+    take(deque.pop());
+  }
+  done = true;
+  for (auto& thread : thieves) {
+    thread.join();
+  }
+
+  // each item taken exactly once, by the owner or a thief
+  for (int i = 0; i < kItems; ++i) {
+    ASSERT_EQ(1, taken[i].load()) << "item " << i;
+  }
+}
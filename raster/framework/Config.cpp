@@ -27,10 +27,12 @@
 #include "accelerator/scheduler/ParallelScheduler.h"
 #include "accelerator/stats/Monitor.h"
 #include "accelerator/thread/ThreadUtil.h"
+#include "raster/coroutine/Offload.h"
 #include "raster/framework/Degrader.h"
 #include "raster/framework/FalconSender.h"
 #include "raster/framework/HubAdaptor.h"
 #include "raster/framework/Sampler.h"
+#include "raster/net/LoadBalancer.h"
 
 namespace rdd {
 
@@ -86,7 +88,16 @@ static dynamic defaultService() {
         ("service", "")
         ("conn_timeout", 100000)
         ("recv_timeout", 300000)
-        ("send_timeout", 1000000)));
+        ("send_timeout", 1000000)
+        ("stack_size", 0)
+        ("io_run", false)
+        ("max_concurrency", 0)
+        ("max_queue", 0)
+        ("queue_timeout", 0)
+        ("priority", 0)
+        ("backlog", 64)
+        ("reuse_port", false)
+        ("idle_timeout", 0)));
 }
 
 void configService(const dynamic& j, bool reload) {
@@ -105,7 +116,18 @@ void configService(const dynamic& j, bool reload) {
     timeoutOpt.ctimeout = acc::json::get(v, "conn_timeout", 100000);
     timeoutOpt.rtimeout = acc::json::get(v, "recv_timeout", 300000);
     timeoutOpt.wtimeout = acc::json::get(v, "send_timeout", 1000000);
-    acc::Singleton<HubAdaptor>::get()->configService(service, port, timeoutOpt);
+    ServiceOption serviceOpt;
+    serviceOpt.stackSize = acc::json::get(v, "stack_size", 0);
+    serviceOpt.ioRun = acc::json::get(v, "io_run", false);
+    serviceOpt.maxConcurrency = acc::json::get(v, "max_concurrency", 0);
+    serviceOpt.maxQueue = acc::json::get(v, "max_queue", 0);
+    serviceOpt.queueTimeout = acc::json::get(v, "queue_timeout", 0);
+    serviceOpt.priority = acc::json::get(v, "priority", 0);
+    serviceOpt.backlog = acc::json::get(v, "backlog", 64);
+    serviceOpt.reusePort = acc::json::get(v, "reuse_port", false);
+    serviceOpt.idleTimeout = acc::json::get(v, "idle_timeout", 0);
+    acc::Singleton<HubAdaptor>::get()->configService(
+        service, port, timeoutOpt, serviceOpt);
   }
 }
 
@@ -115,7 +137,9 @@ static dynamic defaultThreadPool() {
       ("io", dynamic::object
         ("thread_count", 4))
       ("0", dynamic::object
-        ("thread_count", 4)));
+        ("thread_count", 4)
+        ("scheduler", "executor")
+        ("bindcpu", false)));
 }
 
 void configThreadPool(const dynamic& j, bool reload) {
@@ -130,7 +154,17 @@ void configThreadPool(const dynamic& j, bool reload) {
     ACCLOG(INFO) << "config thread." << k;
     auto name = k.asString();
     int threadCount = acc::json::get(v, "thread_count", 4);
-    acc::Singleton<HubAdaptor>::get()->configThreads(name, threadCount);
+    if (name == "offload") {
+      acc::Singleton<OffloadPool>::get()->configure(
+          threadCount,
+          acc::json::get(v, "max_queue", 0),
+          acc::json::get(v, "queue_timeout", 0));
+      continue;
+    }
+    auto scheduler = acc::json::get(v, "scheduler", "executor");
+    bool bindCpu = acc::json::get(v, "bindcpu", false);
+    acc::Singleton<HubAdaptor>::get()->configThreads(
+        name, threadCount, scheduler, bindCpu);
   }
 }
 
@@ -264,6 +298,35 @@ void configSampler(const dynamic& j, bool reload) {
   }
 }
 
+static dynamic defaultBalancer() {
+  return dynamic::object
+    ("balancer", dynamic::object());
+}
+
+void configBalancer(const dynamic& j, bool reload) {
+  // reloadable
+  if (!j.isObject()) {
+    ACCLOG(FATAL) << "config balancer error: " << j;
+    return;
+  }
+  ACCLOG(INFO) << "config balancer";
+  for (auto& kv : j.items()) {
+    const dynamic& k = kv.first;
+    const dynamic& v = kv.second;
+    ACCLOG(INFO) << "config balancer." << k;
+    auto policy = acc::json::get(v, "policy", "p2c") == "hash"
+      ? LoadBalancer::kHash : LoadBalancer::kP2C;
+    auto decay = acc::json::get(v, "decay", 10000000);
+    auto replicas = acc::json::getArray<std::string>(v, "replicas");
+    EjectOption eject;
+    eject.failures = acc::json::get(v, "eject_failures", 5);
+    eject.time = acc::json::get(v, "eject_time", 30000000);
+    eject.maxPercent = acc::json::get(v, "max_eject_percent", 50);
+    acc::Singleton<LoadBalancerManager>::get()->setupBalancer(
+        k.asString(), policy, replicas, decay, eject);
+  }
+}
+
 static dynamic defaultJob() {
   return dynamic::object
     ("job", dynamic::object
@@ -300,6 +363,7 @@ std::string generateDefault() {
   d.update(defaultMonitor());
   d.update(defaultDegrader());
   d.update(defaultSampler());
+  d.update(defaultBalancer());
   d.update(defaultJob());
   return toPrettyJson(d);
 }
@@ -35,6 +35,7 @@ void configNet(const acc::dynamic& j, bool reload);
 void configMonitor(const acc::dynamic& j, bool reload);
 void configDegrader(const acc::dynamic& j, bool reload);
 void configSampler(const acc::dynamic& j, bool reload);
+void configBalancer(const acc::dynamic& j, bool reload);
 void configJobGraph(const acc::dynamic& j, bool reload);
 
 class ConfigManager {
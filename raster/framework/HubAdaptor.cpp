@@ -17,6 +17,8 @@
 #include "raster/framework/HubAdaptor.h"
 
 #include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/DeadlineScheduler.h"
+#include "raster/coroutine/WorkStealingScheduler.h"
 
 namespace rdd {
 
@@ -24,15 +26,36 @@ HubAdaptor::HubAdaptor()
   : acceptor_(std::shared_ptr<NetHub>(this)) {
 }
 
-void HubAdaptor::configThreads(const std::string& name, size_t threadCount) {
+void HubAdaptor::configThreads(const std::string& name,
+                               size_t threadCount,
+                               const std::string& scheduler,
+                               bool bindCpu) {
   if (name == "io") {
     auto factory = std::make_shared<acc::ThreadFactory>("IOThreadPool_");
     ioPool_.reset(new acc::IOThreadPoolExecutor(threadCount, factory));
   } else {
+    int poolId = acc::to<int>(name);
     auto factory = std::make_shared<acc::ThreadFactory>("CPUThreadPool" + name + "_");
-    cpuPoolMap_.emplace(
-        acc::to<int>(name),
-        acc::make_unique<acc::CPUThreadPoolExecutor>(threadCount, factory));
+    if (scheduler == "work_stealing") {
+      schedulerMap_.emplace(
+          poolId,
+          acc::make_unique<WorkStealingScheduler>(
+              threadCount, factory, bindCpu));
+    } else if (scheduler == "deadline") {
+      schedulerMap_.emplace(
+          poolId,
+          acc::make_unique<DeadlineScheduler>(threadCount, factory));
+    } else {
+      if (scheduler != "executor") {
+        ACCLOG(WARN) << "unknown scheduler: " << scheduler
+          << ", use executor";
+      }
+      auto executor =
+        std::make_shared<acc::CPUThreadPoolExecutor>(threadCount, factory);
+      cpuPoolMap_.emplace(poolId, executor);
+      schedulerMap_.emplace(
+          poolId, acc::make_unique<ExecutorScheduler>(executor));
+    }
   }
 }
 
@@ -41,21 +64,33 @@ void HubAdaptor::addService(std::unique_ptr<Service> service) {
 }
 
 void HubAdaptor::configService(
-    const std::string& name, int port, const TimeoutOption& timeoutOpt) {
-  acceptor_.configService(name, port, timeoutOpt);
+    const std::string& name,
+    int port,
+    const TimeoutOption& timeoutOpt,
+    const ServiceOption& serviceOpt) {
+  acceptor_.configService(name, port, timeoutOpt, serviceOpt);
 }
 
 void HubAdaptor::startService() {
   acceptor_.start();
 }
 
+FiberScheduler* HubAdaptor::getFiberScheduler(int poolId) {
+  auto it = schedulerMap_.find(poolId);
+  if (it != schedulerMap_.end()) {
+    return it->second.get();
+  }
+  ACCLOG(FATAL) << "CPUThreadPool" << poolId << " not found";
+  return nullptr;
+}
+
 acc::CPUThreadPoolExecutor*
 HubAdaptor::getCPUThreadPoolExecutor(int poolId) {
   auto it = cpuPoolMap_.find(poolId);
   if (it != cpuPoolMap_.end()) {
     return it->second.get();
   }
-  ACCLOG(FATAL) << "CPUThreadPool" << poolId << " not found";
+  noExecutor(poolId);
   return nullptr;
 }
 
@@ -65,12 +100,45 @@ HubAdaptor::getSharedCPUThreadPoolExecutor(int poolId) {
   if (it != cpuPoolMap_.end()) {
     return it->second;
   }
-  ACCLOG(FATAL) << "CPUThreadPool" << poolId << " not found";
+  noExecutor(poolId);
   return nullptr;
 }
 
+void HubAdaptor::noExecutor(int poolId) {
+  if (schedulerMap_.count(poolId)) {
+    ACCLOG(FATAL) << "CPUThreadPool" << poolId << " has no executor:"
+      << " its scheduler is not \"executor\", configure another pool"
+      << " of \"executor\" for executor users (e.g. ParallelScheduler)";
+    return;
+  }
+  ACCLOG(FATAL) << "CPUThreadPool" << poolId << " not found";
+}
+
 acc::EventLoop* HubAdaptor::getEventLoop() {
-  ioPool_->getEventLoop();
+  return ioPool_->getEventLoop();
+}
+
+namespace {
+
+// Collects the loop of each thread of an IO pool, the pool calls
+// threadStarted() for its running threads when the observer is added.
+class LoopCollector : public acc::ThreadPoolExecutor::Observer {
+ public:
+  void threadStarted(acc::ThreadPoolExecutor::ThreadHandle* h) override {
+    loops.push_back(acc::IOThreadPoolExecutor::getEventLoop(h));
+  }
+  void threadStopped(acc::ThreadPoolExecutor::ThreadHandle*) override {}
+
+  std::vector<acc::EventLoop*> loops;
+};
+
+}
+
+std::vector<acc::EventLoop*> HubAdaptor::getEventLoops() {
+  auto collector = std::make_shared<LoopCollector>();
+  ioPool_->addObserver(collector);
+  ioPool_->removeObserver(collector);
+  return collector->loops;
 }
 
 } // namespace rdd
@@ -29,28 +29,40 @@ class HubAdaptor : public NetHub {
  public:
   HubAdaptor();
 
-  void configThreads(const std::string& name, size_t threadCount);
+  // scheduler: "executor" (default), "work_stealing" or "deadline",
+  // io pool ignores it.  bindCpu works with "work_stealing" only.
+  void configThreads(const std::string& name,
+                     size_t threadCount,
+                     const std::string& scheduler = "executor",
+                     bool bindCpu = false);
 
   void addService(std::unique_ptr<Service> service);
 
   void configService(
       const std::string& name,
       int port,
-      const TimeoutOption& timeoutOpt);
+      const TimeoutOption& timeoutOpt,
+      const ServiceOption& serviceOpt = ServiceOption());
 
   void startService();
 
   // FiberHub
-  acc::CPUThreadPoolExecutor* getCPUThreadPoolExecutor(int poolId) override;
+  FiberScheduler* getFiberScheduler(int poolId) override;
   // NetHub
   acc::EventLoop* getEventLoop() override;
+  std::vector<acc::EventLoop*> getEventLoops() override;
 
+  // only for pools of "executor" scheduler, fatal for the others
+  acc::CPUThreadPoolExecutor* getCPUThreadPoolExecutor(int poolId);
   std::shared_ptr<acc::CPUThreadPoolExecutor>
     getSharedCPUThreadPoolExecutor(int poolId);
 
  private:
+  void noExecutor(int poolId);
+
   std::unique_ptr<acc::IOThreadPoolExecutor> ioPool_;
   std::map<int, std::shared_ptr<acc::CPUThreadPoolExecutor>> cpuPoolMap_;
+  std::map<int, std::unique_ptr<FiberScheduler>> schedulerMap_;
 
   Acceptor acceptor_;
 };
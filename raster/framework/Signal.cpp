@@ -16,12 +16,18 @@
 
 #include "raster/framework/Signal.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
+
 #include "accelerator/Backtrace.h"
 #include "accelerator/Exception.h"
 #include "accelerator/Logging.h"
 #include "accelerator/MemoryProtect.h"
 #include "accelerator/ProcessUtil.h"
 #include "accelerator/Singleton.h"
+#include "raster/coroutine/FiberRegistry.h"
 #include "raster/framework/Config.h"
 
 namespace rdd {
@@ -40,6 +46,31 @@ static void shutdownSignalHandler(int signo) {
   acc::Singleton<Shutdown>::get()->run();
 }
 
+// the handler only writes a byte, the dumper thread does the rest
+static int fiberDumpPipe[2] = {-1, -1};
+
+static void fiberDumpSignalHandler(int signo) {
+  int saved = errno;
+  char c = 0;
+  ssize_t n = ::write(fiberDumpPipe[1], &c, 1);  // full: one is pending
+  (void)n;
+  errno = saved;
+}
+
+static void fiberDumpLoop(int fd) {
+  char buf[64];
+  while (true) {
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n > 0) {
+      ACCLOG(INFO) << "signal received, dump fibers";
+      FiberRegistry::get()->dump();
+    } else if (n == -1 && errno != EINTR) {
+      ACCPLOG(ERROR) << "fd(" << fd << "): read fiber dump pipe failed";
+      return;
+    }
+  }
+}
+
 static void memoryProtectSignalHandler(int signo, siginfo_t* info, void*) {
   std::array<char, 128> buffer;
   int n = snprintf(buffer.data(), buffer.size(),
@@ -82,6 +113,17 @@ void setupShutdownSignal(int signo) {
   setupSignal(signo, shutdownSignalHandler);
 }
 
+void setupFiberDumpSignal(int signo) {
+  if (fiberDumpPipe[1] == -1) {
+    if (::pipe2(fiberDumpPipe, O_CLOEXEC) == -1 ||
+        ::fcntl(fiberDumpPipe[1], F_SETFL, O_NONBLOCK) == -1) {
+      ACCPLOG(FATAL) << "signal '" << strsignal(signo) << "' create pipe";
+    }
+    std::thread(fiberDumpLoop, fiberDumpPipe[0]).detach();
+  }
+  setupSignal(signo, fiberDumpSignalHandler);
+}
+
 void setupMemoryProtectSignal() {
   setupSignal(SIGSEGV, memoryProtectSignalHandler);
 }
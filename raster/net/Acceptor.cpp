@@ -27,7 +27,10 @@ void Acceptor::addService(std::unique_ptr<Service> service) {
 }
 
 void Acceptor::configService(
-    const std::string& name, int port, const TimeoutOption& timeout) {
+    const std::string& name,
+    int port,
+    const TimeoutOption& timeout,
+    const ServiceOption& option) {
   auto service = acc::get_deref_smart_ptr(services_, name);
   if (!service) {
     ACCLOG(FATAL) << "service: [" << name << "] not added";
@@ -35,15 +38,22 @@ void Acceptor::configService(
   }
 
   service->makeChannel(port, timeout);
-  listen(service);
+  service->channel()->setServiceOption(option);
+  if (service->channel()->admission()) {
+    hub_->watchQueue(service->channel()->admission());
+  }
+  if (!option.reusePort) {
+    listen(service);
+  }
 }
 
-void Acceptor::listen(Service* service, int backlog) {
+void Acceptor::listen(Service* service, acc::EventLoop* homeLoop) {
   int port = service->channel()->id();
   auto socket = Socket::createAsyncSocket();
   if (!socket ||
+      (homeLoop && !(socket->setReusePort())) ||
       !(socket->bind(port)) ||
-      !(socket->listen(backlog))) {
+      !(socket->listen(service->channel()->serviceOption().backlog))) {
     throw std::runtime_error("socket listen failed");
   }
 
@@ -51,11 +61,21 @@ void Acceptor::listen(Service* service, int backlog) {
   event->setState(Event::kListen);
   event->setCompleteCallback([&](Event* ev) { hub_->execute(ev); });
   event->setCloseCallback([&](Event* ev) { hub_->execute(ev); });
-  loop_->addEvent(event);
+  // accepted connections stay on the loop of their listener
+  event->setHomeLoop(homeLoop);
+  (homeLoop ? homeLoop : loop_.get())->addEvent(event);
   ACCLOG(INFO) << *event << " listen on port=" << port;
 }
 
 void Acceptor::start() {
+  for (auto& kv : services_) {
+    auto service = kv.second.get();
+    if (service->channel() && service->channel()->serviceOption().reusePort) {
+      for (auto loop : hub_->getEventLoops()) {
+        listen(service, loop);
+      }
+    }
+  }
   loop_->loop();
 }
 
@@ -31,13 +31,16 @@ class Acceptor {
   void configService(
       const std::string& name,
       int port,
-      const TimeoutOption& timeout);
+      const TimeoutOption& timeout,
+      const ServiceOption& option = ServiceOption());
 
+  // Services of reusePort listen here, when the IO loops are up.
   void start();
   void stop();
 
  private:
-  void listen(Service* service, int backlog = 64);
+  // on loop_ if homeLoop is nullptr, else on homeLoop with SO_REUSEPORT
+  void listen(Service* service, acc::EventLoop* homeLoop = nullptr);
 
   std::shared_ptr<NetHub> hub_;
   std::unique_ptr<acc::EventLoop> loop_;
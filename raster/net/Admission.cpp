@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/Admission.h"
+
+#include "accelerator/Singleton.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+
+namespace rdd {
+
+Admission::~Admission() {
+  acc::Singleton<SharedTimingWheel>::get()->cancel(&timer_);
+}
+
+Admission::Result Admission::admit(Event* event) {
+  auto wheel = acc::Singleton<SharedTimingWheel>::get();
+  // no loop ticks the wheel, expire the queue on admit and release
+  bool driven = wheel->driven();
+  std::vector<Event*> expired;
+  Result r = kRun;
+  size_t n;
+  bool arm = false;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!driven && expireCallback_) {
+      popExpired(acc::timestampNow(), expired);
+    }
+    if (running_ < maxConcurrency_) {
+      ++running_;
+    } else if (queue_.size() < maxQueue_) {
+      queue_.push_back({event, acc::timestampNow()});
+      r = kQueued;
+      // one timer for the queue head, rearmed by itself
+      if (queueTimeout_ > 0 && expireCallback_ && !timerArmed_ &&
+          driven) {
+        timerArmed_ = true;
+        arm = true;
+      }
+    } else {
+      r = kReject;
+    }
+    n = queue_.size();
+  }
+  if (arm) {
+    wheel->schedule(&timer_, queueTimeout_);
+  }
+  for (auto& ev : expired) {
+    ACCMON_CNT("service.reject-" + name_);
+    ACCMON_CNT("service.queue_timeout-" + name_);
+    expireCallback_(ev);
+  }
+  ACCMON_AVG("service.queue_size-" + name_, n);
+  ACCMON_MAX("service.queue_size-" + name_ + ".max", n);
+  if (r == kReject) {
+    ACCMON_CNT("service.reject-" + name_);
+  }
+  return r;
+}
+
+Event* Admission::release(std::vector<Event*>& expired) {
+  Event* event = nullptr;
+  uint64_t now = acc::timestampNow();
+  uint64_t wait = 0;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    popExpired(now, expired);
+    if (!queue_.empty()) {
+      Item item = queue_.front();
+      queue_.pop_front();
+      wait = now > item.timestamp ? now - item.timestamp : 0;
+      event = item.event;
+    } else {
+      --running_;
+    }
+  }
+  if (event) {
+    ACCMON_AVG("service.queue_wait-" + name_, wait / 1000);
+  }
+  for (size_t i = 0; i < expired.size(); ++i) {
+    ACCMON_CNT("service.reject-" + name_);
+    ACCMON_CNT("service.queue_timeout-" + name_);
+  }
+  return event;
+}
+
+uint64_t Admission::popExpired(uint64_t now, std::vector<Event*>& expired) {
+  while (!queue_.empty()) {
+    uint64_t expire = queue_.front().timestamp + queueTimeout_;
+    if (queueTimeout_ == 0 || now <= expire) {
+      return queueTimeout_ > 0 ? expire : 0;
+    }
+    expired.push_back(queue_.front().event);
+    queue_.pop_front();
+  }
+  return 0;
+}
+
+void Admission::onTimer() {
+  std::vector<Event*> expired;
+  uint64_t now = acc::timestampNow();
+  uint64_t next;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    next = popExpired(now, expired);
+    timerArmed_ = next != 0;
+  }
+  for (auto& event : expired) {
+    ACCMON_CNT("service.reject-" + name_);
+    ACCMON_CNT("service.queue_timeout-" + name_);
+    expireCallback_(event);
+  }
+  if (next != 0) {
+    acc::Singleton<SharedTimingWheel>::get()->schedule(&timer_, next - now);
+  }
+}
+
+size_t Admission::running() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return running_;
+}
+
+size_t Admission::queued() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return queue_.size();
+}
+
+} // namespace rdd
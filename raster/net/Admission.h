@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "raster/net/TimingWheel.h"
+
+namespace rdd {
+
+class Event;
+
+/*
+ * Per-service admission control.
+ *
+ * At most maxConcurrency requests run at a time, the others wait in a
+ * bounded FIFO queue.  A request is rejected when the queue is full, or
+ * when it has waited longer than queueTimeout (us, 0 for no limit).  The
+ * queue timeout is enforced by a timer on the SharedTimingWheel if an
+ * expire callback is set and a loop drives the wheel, else only as
+ * requests are admitted or finish.
+ */
+class Admission {
+ public:
+  enum Result {
+    kRun,
+    kQueued,
+    kReject,
+  };
+
+  Admission(const std::string& name,
+            size_t maxConcurrency,
+            size_t maxQueue,
+            uint64_t queueTimeout)
+    : name_(name),
+      maxConcurrency_(maxConcurrency),
+      maxQueue_(maxQueue),
+      queueTimeout_(queueTimeout) {
+    timer_.callback = [this]() { onTimer(); };
+  }
+
+  ~Admission();
+
+  // Called with each request expired in the queue, from the timer (or
+  // from admit if the wheel is not driven).
+  void setExpireCallback(std::function<void(Event*)> callback) {
+    expireCallback_ = std::move(callback);
+  }
+
+  Result admit(Event* event);
+
+  // Finish a running request, return the next queued one to run (which
+  // takes over the slot) or nullptr.  Expired ones are moved to expired.
+  Event* release(std::vector<Event*>& expired);
+
+  size_t running() const;
+  size_t queued() const;
+
+  Admission(const Admission&) = delete;
+  Admission& operator=(const Admission&) = delete;
+
+ private:
+  struct Item {
+    Event* event;
+    uint64_t timestamp;
+  };
+
+  // pop the expired head items, return the next expire time or 0,
+  // under lock_
+  uint64_t popExpired(uint64_t now, std::vector<Event*>& expired);
+  void onTimer();
+
+  std::string name_;
+  size_t maxConcurrency_;
+  size_t maxQueue_;
+  uint64_t queueTimeout_;
+
+  mutable std::mutex lock_;
+  size_t running_{0};
+  std::deque<Item> queue_;
+
+  std::function<void(Event*)> expireCallback_;
+  TimingWheel::Timer timer_;
+  bool timerArmed_{false};
+};
+
+} // namespace rdd
@@ -16,14 +16,18 @@
 
 #include "raster/net/AsyncClient.h"
 
+#include <mutex>
+
+#include "accelerator/stats/Monitor.h"
 #include "raster/net/EventPool.h"
+#include "raster/net/FiberTimer.h"
 
 namespace rdd {
 
 AsyncClient::AsyncClient(std::shared_ptr<NetHub> hub,
                          const Peer& peer,
                          const TimeoutOption& timeout)
-  : hub_(hub), peer_(peer), timeout_(timeout) {
+  : hub_(hub), peer_(peer), peerStr_(peer.describe()), timeout_(timeout) {
   ACCLOG(DEBUG) << "AsyncClient: " << peer_ << ", timeout=" << timeout_;
 }
 
@@ -36,28 +40,73 @@ AsyncClient::AsyncClient(std::shared_ptr<NetHub> hub,
 
 AsyncClient::AsyncClient(std::shared_ptr<NetHub> hub,
                          const ClientOption& option)
-  : AsyncClient(hub, option.peer, option.timeout) {}
+  : AsyncClient(hub, option.peer, option.timeout) {
+  if (option.pool.enabled()) {
+    keepalive_ = true;
+    poolOption_ = option.pool;
+  }
+  if (option.breaker.enabled()) {
+    breaker_ = acc::Singleton<CircuitBreakerManager>::get()->getBreaker(
+        peer_, option.breaker);
+  }
+}
 
 void AsyncClient::close() {
   freeConnection();
 }
 
 bool AsyncClient::connect() {
+  if (breaker_) {
+    ticket_ = breaker_->allow();
+    if (!ticket_) {
+      ACCLOG(WARN) << "peer[" << peer_ << "] breaker is open, fail fast";
+      return false;
+    }
+  }
+  callTime_ = acc::timestampNow();
   if (!initConnection()) {
+    if (breaker_) {
+      breaker_->record(ticket_, false, 0);
+    }
     return false;
   }
   ACCLOG(V2) << *event() << " connect";
   Fiber::Task* task = getCurrentFiberTask();
+  FiberManager::setWait(Fiber::kWaitBackend, peerStr_.c_str());
   event_->setTask(task);
-  task->blockCallbacks.push_back([&]() { hub_->addEvent(event()); });
+  // an inline task is resumed on its loop only
+  event_->setHomeLoop(static_cast<acc::EventLoop*>(task->ioHome));
+  // by value, the event may be abandoned before the yield
+  NetHub* hub = hub_.get();
+  Event* event = event_.get();
+  task->blockCallbacks.push_back([hub, event]() { hub->addEvent(event); });
   return true;
 }
 
+std::unique_ptr<Event> AsyncClient::abandon() {
+  if (keepalive_ && event_) {
+    pool()->release();
+  }
+  return std::move(event_);
+}
+
+EventPool* AsyncClient::pool() {
+  if (!pool_) {
+    pool_ = acc::Singleton<EventPoolManager>::get()->getPool(
+        peer_, poolOption_);
+    pool_->setChannel(channel_);
+  }
+  return pool_;
+}
+
+size_t AsyncClient::warmup() {
+  return keepalive_ ? pool()->warmup() : 0;
+}
+
 bool AsyncClient::initConnection() {
   if (keepalive_) {
-    auto pool = acc::Singleton<EventPoolManager>::get()->getPool(peer_.port());
-    auto event = pool->get(peer_);
-    if (event && event->socket()->isConnected()) {
+    auto event = pool()->get();
+    if (event) {
       event->reset();
       event->setState(Event::kToWrite);
       event_ = std::move(event);
@@ -65,6 +114,10 @@ bool AsyncClient::initConnection() {
         << " connect (keep-alive,seqid=" << event_->seqid() << ")";
       return true;
     }
+    if (!pool_->acquire()) {
+      ACCLOG(WARN) << "peer[" << peer_ << "] exceed pool capacity";
+      return false;
+    }
   }
   auto socket = Socket::createAsyncSocket();
   if (socket &&
@@ -76,13 +129,23 @@ bool AsyncClient::initConnection() {
     ACCLOG(DEBUG) << "peer[" << peer_ << "] connect";
     return true;
   }
+  if (keepalive_) {
+    pool_->release();
+  }
   return false;
 }
 
 void AsyncClient::freeConnection() {
-  if (keepalive_ && event_->state() != Event::kFail) {
-    auto pool = acc::Singleton<EventPoolManager>::get()->getPool(peer_.port());
-    pool->giveBack(std::move(event_));
+  if (breaker_ && event_) {
+    breaker_->record(ticket_, event_->state() != Event::kFail,
+                     acc::timePassed(callTime_));
+  }
+  if (keepalive_ && event_) {
+    if (event_->state() != Event::kFail) {
+      pool()->giveBack(std::move(event_));
+    } else {
+      pool()->release();
+    }
   }
   event_ = nullptr;
 }
@@ -90,8 +153,10 @@ void AsyncClient::freeConnection() {
 bool yieldMultiTask(std::initializer_list<AsyncClient*> clients) {
   int size = clients.size();
   if (size != 0) {
-    std::vector<Event*> events(size);
-    std::vector<NetHub*> hubs(size);
+    std::vector<Event*> events;
+    std::vector<NetHub*> hubs;
+    events.reserve(size);
+    hubs.reserve(size);
     for (auto& i : clients) {
       if (i->connected()) {
         events.push_back(i->event());
@@ -110,4 +175,125 @@ bool yieldMultiTask(std::initializer_list<AsyncClient*> clients) {
   return false;
 }
 
+namespace {
+
+// Shared by a hedged call and the callbacks of its events, which outlive
+// the call for an abandoned event.
+struct HedgeRace {
+  std::mutex lock;
+  HedgePolicy* policy{nullptr};
+  uint64_t start{0};
+  FiberTimer* timer{nullptr};
+  int winner{-1};
+  size_t sent{0};
+  size_t done{0};
+  bool finished[2] = {false, false};
+  std::unique_ptr<Event> abandoned[2];
+};
+
+void watchHedge(std::shared_ptr<HedgeRace> race, int i, Event* event) {
+  auto cb = [race, i](Event* ev) {
+    if (i == 0 && ev->state() != Event::kFail) {
+      // the primary's own latency, even if the hedge won
+      race->policy->addLatency(acc::timestampNow() - race->start);
+    }
+    std::lock_guard<std::mutex> guard(race->lock);
+    race->finished[i] = true;
+    ++race->done;
+    if (race->abandoned[i]) {
+      // running in its callback, not to be freed here
+      race->abandoned[i].release()->deleteAfterCallback();
+      return;
+    }
+    // a failure wins only if nothing else is in flight
+    if (race->winner < 0 &&
+        (ev->state() != Event::kFail || race->done == race->sent)) {
+      race->winner = i;
+      if (race->timer) {
+        race->timer->cancel();
+      }
+    }
+  };
+  event->setCompleteCallback(cb);
+  event->setCloseCallback(cb);
+}
+
+// Wait until a winner or timeout.  Yield even if there is a winner, so
+// the events connected are added to the loop.
+void waitHedge(HedgeRace* race, uint64_t timeout) {
+  FiberTimer timer;
+  {
+    std::lock_guard<std::mutex> guard(race->lock);
+    if (race->winner >= 0) {
+      timeout = 0;
+    } else {
+      race->timer = &timer;
+    }
+  }
+  timer.waitFor(timeout);
+  std::lock_guard<std::mutex> guard(race->lock);
+  race->timer = nullptr;
+}
+
+}
+
+AsyncClient* hedgeTask(HedgePolicy& policy,
+                       AsyncClient* primary,
+                       AsyncClient* backup,
+                       const std::function<bool(AsyncClient*)>& send) {
+  AsyncClient* clients[2] = {primary, backup};
+  auto race = std::make_shared<HedgeRace>();
+  auto& timeout = primary->timeoutOption();
+  uint64_t budget = timeout.ctimeout + timeout.rtimeout + timeout.wtimeout;
+  race->policy = &policy;
+  race->start = acc::timestampNow();
+
+  policy.addRequest();
+  if (!primary->connect() || !send(primary)) {
+    return nullptr;
+  }
+  race->sent = 1;
+  watchHedge(race, 0, primary->event());
+
+  uint64_t delay = policy.delay();
+  waitHedge(race.get(), delay > 0 ? delay : budget);
+
+  bool hedge = false;
+  {
+    std::lock_guard<std::mutex> guard(race->lock);
+    hedge = race->winner < 0;
+  }
+  if (hedge && delay > 0 && policy.tryHedge() &&
+      backup->connect() && send(backup)) {
+    {
+      std::lock_guard<std::mutex> guard(race->lock);
+      ++race->sent;
+    }
+    watchHedge(race, 1, backup->event());
+    ACCMON_CNT("hedge.sent-" + policy.name());
+    waitHedge(race.get(), budget);
+  }
+
+  std::lock_guard<std::mutex> guard(race->lock);
+  for (size_t i = 0; i < race->sent; ++i) {
+    if (int(i) == race->winner || race->finished[i]) {
+      // back to the hub, as an event not hedged
+      NetHub* hub = clients[i]->hub();
+      auto execute = [hub](Event* ev) { hub->execute(ev); };
+      clients[i]->event()->setCompleteCallback(execute);
+      clients[i]->event()->setCloseCallback(execute);
+    } else {
+      race->abandoned[i] = clients[i]->abandon();
+    }
+  }
+  if (race->winner < 0 ||
+      clients[race->winner]->event()->state() == Event::kFail) {
+    return nullptr;
+  }
+  if (race->winner == 1) {
+    ACCMON_CNT("hedge.won-" + policy.name());
+  }
+  return clients[race->winner];
+}
+
 } // namespace rdd
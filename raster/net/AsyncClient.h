@@ -16,10 +16,13 @@
 
 #pragma once
 
+#include <functional>
 #include <initializer_list>
 
 #include "raster/coroutine/FiberManager.h"
+#include "raster/net/CircuitBreaker.h"
 #include "raster/net/Event.h"
+#include "raster/net/Hedge.h"
 #include "raster/net/NetHub.h"
 #include "raster/net/NetUtil.h"
 #include "raster/net/Socket.h"
@@ -31,6 +34,8 @@
  */
 namespace rdd {
 
+class EventPool;
+
 class AsyncClient {
  public:
   AsyncClient(std::shared_ptr<NetHub> hub,
@@ -66,6 +71,14 @@ class AsyncClient {
     return event_.get();
   }
 
+  const TimeoutOption& timeoutOption() const {
+    return timeout_;
+  }
+
+  // Give up the call in flight, the returned event is still on the loop
+  // and must be kept until its callback.
+  std::unique_ptr<Event> abandon();
+
   void setKeepAlive() {
     keepalive_ = true;
   }
@@ -74,20 +87,42 @@ class AsyncClient {
     return keepalive_;
   }
 
+  // Pre-connect the keep-alive pool of the peer up to its minIdle, call
+  // at startup.  Return # of new connections.
+  size_t warmup();
+
  protected:
   virtual std::shared_ptr<Channel> makeChannel() = 0;
 
   bool initConnection();
   void freeConnection();
 
+  EventPool* pool();
+
   std::shared_ptr<NetHub> hub_;
   Peer peer_;
+  std::string peerStr_;  // wait detail of each connect
   TimeoutOption timeout_;
   bool keepalive_{false};
+  PoolOption poolOption_;
+  EventPool* pool_{nullptr};
+  CircuitBreaker* breaker_{nullptr};
+  CircuitBreaker::Ticket ticket_;
+  uint64_t callTime_{0};
   std::unique_ptr<Event> event_;
   std::shared_ptr<Channel> channel_;
 };
 
+// Connect primary and send by send, if no reply within the delay of
+// policy and the budget allows, connect backup and send to it too.
+// Return the first client answered, the other is abandoned; nullptr if
+// both fail.  policy is fed the primary's latency when it completes, so
+// it must outlive an abandoned primary (keep one per backend).
+AsyncClient* hedgeTask(HedgePolicy& policy,
+                       AsyncClient* primary,
+                       AsyncClient* backup,
+                       const std::function<bool(AsyncClient*)>& send);
+
 template <class C>
 class MultiAsyncClient {
  public:
@@ -162,6 +197,17 @@ class MultiAsyncClient {
     return clients_[i]->send(sendFunc, requests...);
   }
 
+  // Hedged call to i backed up by j, both not connected: send(C*) sends
+  // the request.  Return the index of the one to recv, -1 on failure.
+  template <class F>
+  int hedge(HedgePolicy& policy, size_t i, size_t j, F send) {
+    assert(i < count() && j < count());
+    AsyncClient* client = hedgeTask(
+        policy, clients_[i].get(), clients_[j].get(),
+        [&](AsyncClient* c) { return send(static_cast<C*>(c)); });
+    return !client ? -1 : client == clients_[i].get() ? i : j;
+  }
+
   bool yield() {
     if (!clients_.empty()) {
       std::vector<Event*> events;
@@ -188,4 +234,15 @@ class MultiAsyncClient {
 // yield task for multiple clients with different types
 bool yieldMultiTask(std::initializer_list<AsyncClient*> clients);
 
+// Single hedged call, as fetch() of C with send(C&) and recv(C&).
+template <class C, class Send, class Recv>
+bool hedgedFetch(HedgePolicy& policy,
+                 C& primary, C& backup,
+                 Send send, Recv recv) {
+  AsyncClient* client = hedgeTask(
+      policy, &primary, &backup,
+      [&](AsyncClient* c) { return send(*static_cast<C*>(c)); });
+  return client && recv(*static_cast<C*>(client));
+}
+
 } // namespace rdd
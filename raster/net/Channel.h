@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <string>
+
+#include "raster/net/Admission.h"
 #include "raster/net/Processor.h"
 #include "raster/net/Transport.h"
 
@@ -40,6 +43,20 @@ class Channel {
 
   TimeoutOption timeoutOption() const { return timeout_; }
 
+  const ServiceOption& serviceOption() const { return serviceOpt_; }
+  void setServiceOption(const ServiceOption& opt) {
+    serviceOpt_ = opt;
+    if (opt.maxConcurrency > 0) {
+      admission_.reset(new Admission(std::to_string(id_),
+                                     opt.maxConcurrency,
+                                     opt.maxQueue,
+                                     opt.queueTimeout));
+    }
+  }
+
+  // nullptr if the service has no concurrency limit
+  Admission* admission() const { return admission_.get(); }
+
   TransportFactory* transportFactory() const {
     return transportFactory_.get();
   }
@@ -52,6 +69,8 @@ class Channel {
   int id_;
   Peer peer_;
   TimeoutOption timeout_;
+  ServiceOption serviceOpt_;
+  std::unique_ptr<Admission> admission_;
   std::unique_ptr<TransportFactory> transportFactory_;
   std::unique_ptr<ProcessorFactory> processorFactory_;
 };
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/CircuitBreaker.h"
+
+#include "accelerator/Logging.h"
+#include "accelerator/Memory.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+
+#define RDD_BREAKER_STR(state) #state
+
+namespace {
+  static const char* stateStrings[] = {
+    RDD_BREAKER_GEN(RDD_BREAKER_STR)
+  };
+}
+
+namespace rdd {
+
+using acc::SharedMutex;
+
+constexpr size_t CircuitBreaker::kBuckets;
+
+CircuitBreaker::CircuitBreaker(const Peer& peer, const BreakerOption& option)
+  : peer_(peer),
+    option_(option),
+    label_(std::to_string(peer.port())) {
+  option_.window = std::max(option_.window, uint64_t(kBuckets));
+  option_.probes = std::max(option_.probes, size_t(1));
+}
+
+CircuitBreaker::Ticket CircuitBreaker::allow() {
+  uint64_t now = acc::timestampNow();
+  Ticket ticket;
+  ticket.allowed = true;
+  State from, to;
+  {
+    acc::SpinLockGuard guard(lock_);
+    from = state_;
+    switch (state_) {
+      case kOpen:
+        if (now - stateTime_ < option_.openTime) {
+          ticket.allowed = false;
+          break;
+        }
+        setState(kHalfOpen, now);
+        // fall through
+      case kHalfOpen:
+        // probes lost (never recorded) are given up after openTime
+        if (probing_ >= option_.probes &&
+            now - stateTime_ >= option_.openTime) {
+          probing_ = 0;
+          stateTime_ = now;
+          ++probeRound_;
+        }
+        if (probing_ + probed_ >= option_.probes) {
+          ticket.allowed = false;
+          break;
+        }
+        ++probing_;
+        ticket.probe = probeRound_;
+        break;
+      default:
+        break;
+    }
+    to = state_;
+  }
+  if (from != to) {
+    onTransition(from, to);
+  }
+  if (!ticket) {
+    ACCMON_CNT("breaker.reject-" + label_);
+  }
+  return ticket;
+}
+
+void CircuitBreaker::record(const Ticket& ticket, bool ok, uint64_t latency) {
+  uint64_t now = acc::timestampNow();
+  bool slow = option_.slowTime > 0 && latency > option_.slowTime;
+  State from, to;
+  Bucket sum;
+  {
+    acc::SpinLockGuard guard(lock_);
+    from = state_;
+    switch (state_) {
+      case kHalfOpen:
+        // a call taken while closed, or a probe of a given up round
+        if (ticket.probe != probeRound_) {
+          break;
+        }
+        if (probing_ > 0) {
+          --probing_;
+        }
+        if (!ok || slow) {
+          setState(kOpen, now);
+        } else if (++probed_ >= option_.probes) {
+          setState(kClosed, now);
+        }
+        break;
+      case kClosed: {
+        uint64_t width = option_.window / kBuckets;
+        uint64_t index = now / width;
+        Bucket& bucket = buckets_[index % kBuckets];
+        if (bucket.index != index) {
+          bucket = Bucket();
+          bucket.index = index;
+        }
+        ++bucket.calls;
+        bucket.errors += !ok;
+        bucket.slows += slow;
+        for (auto& b : buckets_) {
+          if (b.index + kBuckets > index) {
+            sum.calls += b.calls;
+            sum.errors += b.errors;
+            sum.slows += b.slows;
+          }
+        }
+        if (sum.calls >= option_.minCalls &&
+            ((option_.errorRate > 0 &&
+              sum.errors >= option_.errorRate * sum.calls) ||
+             (option_.slowRate > 0 &&
+              sum.slows >= option_.slowRate * sum.calls))) {
+          setState(kOpen, now);
+        }
+        break;
+      }
+      default:
+        // late result of a call before opening
+        break;
+    }
+    to = state_;
+  }
+  if (from == kClosed && to == kOpen) {
+    ACCLOG(WARN) << "peer[" << peer_ << "] " << sum.errors << " errors, "
+      << sum.slows << " slow in " << sum.calls << " calls";
+  }
+  if (from != to) {
+    onTransition(from, to);
+  }
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+  acc::SpinLockGuard guard(lock_);
+  return state_;
+}
+
+const char* CircuitBreaker::stateName(State state) {
+  return stateStrings[state];
+}
+
+void CircuitBreaker::setState(State state, uint64_t now) {
+  state_ = state;
+  stateTime_ = now;
+  probing_ = 0;
+  probed_ = 0;
+  if (state == kHalfOpen) {
+    ++probeRound_;
+  }
+  if (state == kClosed) {
+    resetWindow();
+  }
+}
+
+void CircuitBreaker::onTransition(State from, State to) {
+  ACCLOG(WARN) << "peer[" << peer_ << "] breaker "
+    << stateName(from) << " -> " << stateName(to);
+  ACCMON_CNT("breaker." + std::string(stateName(to)) + "-" + label_);
+}
+
+void CircuitBreaker::resetWindow() {
+  for (auto& b : buckets_) {
+    b = Bucket();
+  }
+}
+
+CircuitBreaker* CircuitBreakerManager::getBreaker(
+    const Peer& peer, const BreakerOption& option) {
+  {
+    SharedMutex::ReadHolder guard(lock_);
+    auto it = breakers_.find(peer);
+    if (it != breakers_.end()) {
+      return it->second.get();
+    }
+  }
+  SharedMutex::WriteHolder guard(lock_);
+  auto& breaker = breakers_[peer];
+  if (!breaker) {
+    breaker = acc::make_unique<CircuitBreaker>(peer, option);
+  }
+  return breaker.get();
+}
+
+} // namespace rdd
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "accelerator/thread/SharedMutex.h"
+#include "accelerator/thread/SpinLock.h"
+#include "raster/net/NetUtil.h"
+
+#define RDD_BREAKER_GEN(x)  \
+  x(Closed),                \
+  x(Open),                  \
+  x(HalfOpen)
+
+#define RDD_BREAKER_ENUM(state) k##state
+
+namespace rdd {
+
+/*
+ * Circuit breaker of a backend peer.
+ *
+ * Closed: calls pass, the error and slow rates are counted over a
+ * sliding window, either over its limit opens the breaker.  Open: calls
+ * fail at once, for openTime.  HalfOpen: a few probe calls pass, all of
+ * them succeeding closes the breaker, any failing opens it again; only
+ * the results of the probes (by their tickets) count then.
+ */
+class CircuitBreaker {
+ public:
+  enum State {
+    RDD_BREAKER_GEN(RDD_BREAKER_ENUM)
+  };
+
+  CircuitBreaker(const Peer& peer, const BreakerOption& option);
+
+  // A call allowed or not, a probe if taken while half-open.
+  struct Ticket {
+    bool allowed{false};
+    uint64_t probe{0};  // round of the probes, 0 for not a probe
+
+    explicit operator bool() const { return allowed; }
+  };
+
+  // Whether a call may go.
+  Ticket allow();
+
+  // Result of a call allowed by the ticket.
+  void record(const Ticket& ticket, bool ok, uint64_t latency);
+
+  State state() const;
+  static const char* stateName(State state);
+
+ private:
+  static constexpr size_t kBuckets = 10;
+
+  struct Bucket {
+    uint64_t index{0};
+    size_t calls{0};
+    size_t errors{0};
+    size_t slows{0};
+  };
+
+  // Under the lock, the transition is logged by onTransition after.
+  void setState(State state, uint64_t now);
+  void onTransition(State from, State to);
+  void resetWindow();
+
+  Peer peer_;
+  BreakerOption option_;
+  std::string label_;
+
+  mutable acc::SpinLock lock_;
+  State state_{kClosed};
+  uint64_t stateTime_{0};
+  size_t probing_{0};
+  size_t probed_{0};
+  uint64_t probeRound_{0};
+  Bucket buckets_[kBuckets];
+};
+
+class CircuitBreakerManager {
+ public:
+  CircuitBreakerManager() {}
+
+  // The option is taken by the first call of a peer.
+  CircuitBreaker* getBreaker(const Peer& peer, const BreakerOption& option);
+
+ private:
+  std::unordered_map<Peer, std::unique_ptr<CircuitBreaker>> breakers_;
+  acc::SharedMutex lock_;
+};
+
+} // namespace rdd
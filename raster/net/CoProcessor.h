@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "raster/Portability.h"
+
+#if RDD_HAVE_COROUTINE
+
+#include "accelerator/Logging.h"
+#include "raster/coroutine/Coroutine.h"
+#include "raster/net/Event.h"
+#include "raster/net/Processor.h"
+
+namespace rdd {
+
+/*
+ * Processor run as a stackless coroutine, so an in-flight request costs
+ * its coroutine frame instead of a fiber stack.  Backends are called by
+ * AsyncClient::connect, send, co_await coYield() and recv (or the co*
+ * methods of the clients).
+ */
+class CoProcessor : public Processor {
+ public:
+  CoProcessor(Event* event) : Processor(event) {}
+  ~CoProcessor() override {}
+
+  virtual CoTask<> coRun() = 0;
+
+  void run() override {
+    ACCLOG(ERROR) << *event_ << " CoProcessor can't run in fiber";
+  }
+};
+
+template <class P>
+class CoProcessorFactory : public ProcessorFactory {
+ public:
+  CoProcessorFactory() {}
+  ~CoProcessorFactory() override {}
+
+  std::unique_ptr<Processor> create(Event* event) override {
+    return acc::make_unique<P>(event);
+  }
+
+  bool stackless() const override { return true; }
+};
+
+class CoEventTask : public StacklessTask {
+ public:
+  CoEventTask(Event* event) : event_(event) {
+    event_->setTask(this);
+  }
+
+  ~CoEventTask() override {}
+
+  void drop() override {
+    event_->processor()->reject();
+    event_->setState(Event::kToWrite);
+  }
+
+  Event* event() const { return event_; }
+
+ protected:
+  CoTask<> start() override {
+    processor_ = event_->processor();
+    return static_cast<CoProcessor*>(processor_.get())->coRun();
+  }
+
+  void finish() override {
+    event_->setState(Event::kToWrite);
+  }
+
+ private:
+  Event* event_;
+  std::unique_ptr<Processor> processor_;
+};
+
+} // namespace rdd
+
+#endif
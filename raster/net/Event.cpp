@@ -16,6 +16,7 @@
 
 #include "raster/net/Event.h"
 
+#include "accelerator/Singleton.h"
 #include "raster/coroutine/FiberManager.h"
 #include "raster/net/Channel.h"
 #include "raster/net/EventTask.h"
@@ -32,6 +33,7 @@ std::atomic<uint64_t> Event::globalSeqid_(1);
 Event::Event(std::shared_ptr<Channel> channel,
              std::unique_ptr<Socket> socket)
   : EventBase(channel->timeoutOption()),
+    ctime_(acc::timestampNow()),
     channel_(channel),
     socket_(std::move(socket)) {
   reset();
@@ -40,14 +42,19 @@ Event::Event(std::shared_ptr<Channel> channel,
 
 Event::~Event() {
   ACCLOG(V2) << *this << " -";
+  if (transport_ && transport_->zeroCopyPending()) {
+    acc::Singleton<ZeroCopyReaper>::get()->adopt(
+        std::move(socket_), std::move(transport_));
+  }
 }
 
 void Event::reset() {
   restart();
 
   seqid_ = globalSeqid_.fetch_add(1);
-  group_ = 0;
+  grouped_ = false;
   forward_ = false;
+  oneway_ = false;
   task_ = nullptr;
 
   if (transport_) {
@@ -62,6 +69,9 @@ void Event::reset() {
 }
 
 std::string Event::label() const {
+  if (fdWait_) {
+    return "wait";
+  }
   return acc::to<std::string>(socket_->roleName()[0], channel_->id());
 }
 
@@ -81,6 +91,9 @@ void Event::setCompleteCallback(std::function<void(Event*)> cb) {
 }
 void Event::callbackOnComplete() {
   completeCallback_(this);
+  if (orphan_) {
+    delete this;
+  }
 }
 
 void Event::setCloseCallback(std::function<void(Event*)> cb) {
@@ -88,6 +101,9 @@ void Event::setCloseCallback(std::function<void(Event*)> cb) {
 }
 void Event::callbackOnClose() {
   closeCallback_(this);
+  if (orphan_) {
+    delete this;
+  }
 }
 
 void Event::copyCallbacks(const Event& event) {
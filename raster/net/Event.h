@@ -27,8 +27,13 @@
 #include "accelerator/io/IOBuf.h"
 #include "raster/coroutine/Fiber.h"
 #include "raster/net/Socket.h"
+#include "raster/net/TimingWheel.h"
 #include "raster/net/Transport.h"
 
+namespace acc {
+class EventLoop;
+}
+
 namespace rdd {
 
 class Channel;
@@ -47,15 +52,35 @@ class Event : public acc::EventBase {
 
   uint64_t seqid() const { return seqid_; }
 
-  int group() const { return group_; }
-  void setGroup(int group) { group_ = group; }
+  // as acc::timestampNow(), kept over reset()
+  uint64_t createTime() const { return ctime_; }
+
+  // one of the events of a group wait of its task
+  bool grouped() const { return grouped_; }
+  void setGrouped(bool grouped) { grouped_ = grouped; }
 
   bool isForward() const { return forward_; }
   void setForward() { forward_ = true; }
 
+  // client event completes on write, no response to read
+  bool isOneway() const { return oneway_; }
+  void setOneway() { oneway_ = true; }
+
+  // waits a fd for a fiber or loop (see FiberIO), not a connection: a
+  // timeout is a result, and its metrics go under label "wait"
+  bool isFdWait() const { return fdWait_; }
+  void setFdWait() { fdWait_ = true; }
+
   Fiber::Task* task() const { return task_; }
   void setTask(Fiber::Task* task) { task_ = task; }
 
+  // loop to return to after processing, nullptr for any IO loop
+  acc::EventLoop* homeLoop() const { return homeLoop_; }
+  void setHomeLoop(acc::EventLoop* loop) { homeLoop_ = loop; }
+
+  // deadline armed on the timing wheel of its loop's EventHandler
+  TimingWheel::Timer* timer() { return &timer_; }
+
   // socket
 
   int fd() const override { return socket_->fd(); }
@@ -100,6 +125,9 @@ class Event : public acc::EventBase {
 
   void copyCallbacks(const Event& event);
 
+  // Owned by nobody now, delete itself once the running callback returns.
+  void deleteAfterCallback() { orphan_ = true; }
+
   // user context
 
   template <class T, class... Args>
@@ -120,17 +148,23 @@ class Event : public acc::EventBase {
   static std::atomic<uint64_t> globalSeqid_;
 
   uint64_t seqid_;
-  int group_;
+  uint64_t ctime_;
+  bool grouped_;
   bool forward_;
+  bool oneway_;
+  bool fdWait_{false};
 
   std::shared_ptr<Channel> channel_;
   std::unique_ptr<Socket> socket_;
   std::unique_ptr<Transport> transport_;
 
   Fiber::Task* task_;
+  acc::EventLoop* homeLoop_{nullptr};
+  TimingWheel::Timer timer_;
 
   std::function<void(Event*)> completeCallback_;
   std::function<void(Event*)> closeCallback_;
+  bool orphan_{false};
 
   acc::UniqueAnyPtr userCtx_;
 };
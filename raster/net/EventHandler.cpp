@@ -16,21 +16,75 @@
 
 #include "raster/net/EventHandler.h"
 
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <map>
+
 #include "accelerator/Logging.h"
+#include "accelerator/Singleton.h"
 #include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/FiberHub.h"
+#include "raster/net/Channel.h"
 #include "raster/net/Event.h"
+#include "raster/net/FiberIO.h"
+#include "raster/net/NotifyTransport.h"
 
 namespace rdd {
 
+namespace {
+
+// the ticker never times out by itself
+const uint64_t kTickerTimeout = uint64_t(1) << 50;
+
+// handlers by loop, for the adders of fd waits
+std::mutex gHandlersLock;
+std::map<acc::EventLoop*, EventHandler*> gHandlers;
+
+// a timeout ends a fd wait normally, no warning for it
+void logTimeout(Event* event, const char* what, uint64_t timeout) {
+  if (event->isFdWait()) {
+    ACCLOG(V1) << *event << " remove " << what << " timeout wait: >"
+      << timeout;
+  } else {
+    ACCLOG(WARN) << *event << " remove " << what << " timeout request: >"
+      << timeout;
+  }
+}
+
+}
+
+EventHandler::EventHandler(acc::EventLoop* loop)
+  : loop_(loop), wheel_(FLAGS_net_timer_tick) {
+  // drives the shared wheel and the reaper even before any deadline
+  startTicker();
+  if (startWaker()) {
+    std::lock_guard<std::mutex> guard(gHandlersLock);
+    gHandlers[loop_] = this;
+  }
+}
+
+EventHandler::~EventHandler() {
+  if (waker_) {
+    std::lock_guard<std::mutex> guard(gHandlersLock);
+    gHandlers.erase(loop_);
+  }
+  if (ticker_) {
+    acc::Singleton<SharedTimingWheel>::get()->removeDriver();
+  }
+}
+
 void EventHandler::onConnect(acc::EventBase* ev) {
   Event* event = reinterpret_cast<Event*>(ev);
 
   assert(event->state() == acc::EventBase::kConnect);
 
+  wheel_.cancel(event->timer());
+
   if (event->isConnectTimeout()) {
     event->setState(acc::EventBase::kTimeout);
-    ACCLOG(WARN) << *event << " remove connect timeout request: >"
-      << event->timeoutOption().ctimeout;
+    logTimeout(event, "connect", event->timeoutOption().ctimeout);
     onTimeout(event);
     return;
   }
@@ -52,34 +106,53 @@ void EventHandler::onListen(acc::EventBase* ev) {
 
   assert(event->state() == acc::EventBase::kListen);
 
-  auto socket = event->socket()->accept();
-  if (!(*socket) ||
-      !(socket->setReuseAddr()) ||
-      // !(socket->setLinger(0)) ||
-      !(socket->setTCPNoDelay()) ||
-      !(socket->setNonBlocking())) {
-    return;
-  }
-  if (Socket::count() >= FLAGS_net_conn_limit) {
-    ACCLOG(WARN) << "exceed connection capacity, drop request";
-    return;
-  }
+  // drain the backlog, one wakeup may stand for many connections
+  std::unique_ptr<Socket> socket;
+  while ((socket = event->socket()->accept())) {
+    if (!(socket->setReuseAddr()) ||
+        // !(socket->setLinger(0)) ||
+        !(socket->setTCPNoDelay())) {
+      continue;
+    }
+    if (Socket::count() >= FLAGS_net_conn_limit) {
+      ACCLOG(WARN) << "exceed connection capacity, drop request";
+      continue;
+    }
 
-  auto evnew = new Event(event->channel(), std::move(socket));
-  evnew->copyCallbacks(*event);
-  ACCLOG(V1) << *evnew << " accepted";
-  evnew->setState(acc::EventBase::kNext);
-  ACCLOG(V2) << *evnew << " add event";
-  loop_->pushEvent(evnew);
-  loop_->dispatchEvent(evnew);
+    auto evnew = new Event(event->channel(), std::move(socket));
+    evnew->copyCallbacks(*event);
+    evnew->setHomeLoop(event->homeLoop());
+    ACCLOG(V1) << *evnew << " accepted";
+    evnew->setState(acc::EventBase::kNext);
+    ACCLOG(V2) << *evnew << " add event";
+    loop_->pushEvent(evnew);
+    armTimer(evnew);
+    loop_->dispatchEvent(evnew);
+  }
 }
 
 void EventHandler::onRead(acc::EventBase* ev) {
   Event* event = reinterpret_cast<Event*>(ev);
 
+  if (event == ticker_.get()) {
+    onTick();
+    return;
+  }
+  if (event == waker_.get()) {
+    onWake();
+    return;
+  }
+  wheel_.cancel(event->timer());
+  bool idle = event->socket()->isServer() &&
+    event->transport()->readBytes() == 0;
+
   event->setState(acc::EventBase::kReading);
 
   int r = event->readData();
+  if (idle && r != 0 && event->transport()->readBytes() != 0) {
+    // a request comes, its read timeout counts from now
+    event->restart();
+  }
   switch (r) {
     case 1: {
       ACCLOG(V1) << *event << " read: complete";
@@ -97,11 +170,11 @@ void EventHandler::onRead(acc::EventBase* ev) {
     case -2: {
       if (event->isReadTimeout()) {
         event->setState(acc::EventBase::kTimeout);
-        ACCLOG(WARN) << *event << " remove read timeout request: >"
-          << event->timeoutOption().rtimeout;
+        logTimeout(event, "read", event->timeoutOption().rtimeout);
         onTimeout(event);
       } else {
         ACCLOG(V1) << *event << " read: again";
+        armTimer(event);
       }
       break;
     }
@@ -118,6 +191,7 @@ void EventHandler::onRead(acc::EventBase* ev) {
 void EventHandler::onWrite(acc::EventBase* ev) {
   Event* event = reinterpret_cast<Event*>(ev);
 
+  wheel_.cancel(event->timer());
   event->setState(acc::EventBase::kWriting);
 
   int r = event->writeData();
@@ -138,11 +212,11 @@ void EventHandler::onWrite(acc::EventBase* ev) {
     case -2: {
       if (event->isWriteTimeout()) {
         event->setState(acc::EventBase::kTimeout);
-        ACCLOG(WARN) << *event << " remove write timeout request: >"
-          << event->timeoutOption().wtimeout;
+        logTimeout(event, "write", event->timeoutOption().wtimeout);
         onTimeout(event);
       } else {
         ACCLOG(V1) << *event << " write: again";
+        armTimer(event);
       }
       break;
     }
@@ -162,10 +236,12 @@ void EventHandler::onTimeout(acc::EventBase *ev) {
 void EventHandler::close(acc::EventBase* ev) {
   Event* event = reinterpret_cast<Event*>(ev);
 
+  wheel_.cancel(event->timer());
   loop_->popEvent(event);
 
   if (event->socket()->isClient()) {
     event->setState(acc::EventBase::kFail);
+    FiberHub::IoScope scope(loop_);
     event->callbackOnClose();  // execute
   } else {
     delete event;
@@ -181,8 +257,7 @@ void EventHandler::onComplete(acc::EventBase* ev) {
   if (event->state() == acc::EventBase::kReaded) {
     if (event->isReadTimeout()) {
       event->setState(acc::EventBase::kTimeout);
-      ACCLOG(WARN) << *event << " remove read timeout request: >"
-        << event->timeoutOption().rtimeout;
+      logTimeout(event, "read", event->timeoutOption().rtimeout);
       onTimeout(event);
       return;
     }
@@ -195,6 +270,7 @@ void EventHandler::onComplete(acc::EventBase* ev) {
       ACCMON_AVG("conn.cost-" + event->label(), event->cost() / 1000);
     }
     if (!event->isForward()) {
+      FiberHub::IoScope scope(loop_);
       event->callbackOnComplete();  // execute
     }
     return;
@@ -203,12 +279,18 @@ void EventHandler::onComplete(acc::EventBase* ev) {
   if (event->state() == acc::EventBase::kWrited) {
     if (event->isWriteTimeout()) {
       event->setState(acc::EventBase::kTimeout);
-      ACCLOG(WARN) << *event << " remove write timeout request: >"
-        << event->timeoutOption().wtimeout;
+      logTimeout(event, "write", event->timeoutOption().wtimeout);
       onTimeout(event);
       return;
     }
 
+    if (event->socket()->isClient() && event->isOneway()) {
+      loop_->popEvent(event);
+      FiberHub::IoScope scope(loop_);
+      event->callbackOnComplete();  // execute
+      return;
+    }
+
     loop_->updateEvent(event, acc::EPoll::kRead);
 
     // server: wait next; client: wait response
@@ -220,6 +302,7 @@ void EventHandler::onComplete(acc::EventBase* ev) {
     } else {
       event->setState(acc::EventBase::kToRead);
     }
+    armTimer(event);
     loop_->dispatchEvent(event);
     return;
   }
@@ -234,4 +317,128 @@ void EventHandler::onError(acc::EventBase* ev) {
   close(event);
 }
 
+void EventHandler::armTimer(Event* event) {
+  if (!ticker_) {
+    return;
+  }
+  auto timeout = event->timeoutOption();
+  uint64_t deadline = event->state() == acc::EventBase::kWriting ||
+                      event->state() == acc::EventBase::kToWrite
+    ? timeout.wtimeout : timeout.rtimeout;
+  if (event->socket()->isServer() &&
+      event->transport()->readBytes() == 0) {
+    uint64_t idleTimeout = event->channel()->serviceOption().idleTimeout;
+    if (idleTimeout > 0) {
+      deadline = idleTimeout;
+    }
+  }
+  uint64_t cost = event->cost();
+  event->timer()->callback = [this, event]() { onTimer(event); };
+  wheel_.schedule(event->timer(), deadline > cost ? deadline - cost : 0);
+}
+
+void EventHandler::onTimer(Event* event) {
+  if (event->socket()->isServer() &&
+      (event->state() == acc::EventBase::kNext ||
+       event->state() == acc::EventBase::kReading) &&
+      event->transport()->readBytes() == 0) {
+    ACCLOG(V1) << *event << " remove idle connection";
+    ACCMON_CNT("conn.idle-" + event->label());
+    close(event);
+    return;
+  }
+  if (event->isFdWait()) {
+    ACCLOG(V1) << *event << " remove timeout wait on "
+      << event->stateName();
+  } else {
+    ACCLOG(WARN) << *event << " remove timeout request on "
+      << event->stateName();
+  }
+  event->setState(acc::EventBase::kTimeout);
+  onTimeout(event);
+}
+
+void EventHandler::onTick() {
+  ticker_->readData();  // consume the expirations
+  uint64_t now = acc::timestampNow();
+  wheel_.advance(now);
+  acc::Singleton<SharedTimingWheel>::get()->advance(now);
+  acc::Singleton<ZeroCopyReaper>::get()->reap(now);
+  ACCMON_AVG("conn.timers", wheel_.size());
+}
+
+bool EventHandler::addWaitEvent(acc::EventLoop* loop, Event* event) {
+  std::lock_guard<std::mutex> guard(gHandlersLock);
+  auto it = gHandlers.find(loop);
+  if (it == gHandlers.end()) {
+    return false;
+  }
+  EventHandler* handler = it->second;
+  bool wake;
+  {
+    std::lock_guard<std::mutex> waitsGuard(handler->waitsLock_);
+    wake = handler->waits_.empty();
+    handler->waits_.push_back(event);
+  }
+  if (wake) {
+    uint64_t one = 1;
+    if (::write(handler->waker_->socket()->fd(), &one, sizeof(one)) == -1) {
+      ACCPLOG(ERROR) << *handler->waker_ << " write eventfd failed";
+    }
+  }
+  return true;
+}
+
+void EventHandler::onWake() {
+  waker_->readData();  // consume the counter
+  std::vector<Event*> waits;
+  {
+    std::lock_guard<std::mutex> guard(waitsLock_);
+    waits.swap(waits_);
+  }
+  for (auto& event : waits) {
+    ACCLOG(V2) << *event << " add event";
+    loop_->pushEvent(event);
+    armTimer(event);
+    loop_->dispatchEvent(event);
+  }
+}
+
+bool EventHandler::startTicker() {
+  int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd == -1) {
+    ACCPLOG(ERROR) << "timerfd_create failed";
+    return false;
+  }
+  struct itimerspec its = {};
+  its.it_value.tv_sec = wheel_.tick() / 1000000;
+  its.it_value.tv_nsec = wheel_.tick() % 1000000 * 1000;
+  its.it_interval = its.it_value;
+  if (::timerfd_settime(fd, 0, &its, nullptr) == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd << "): timerfd_settime failed";
+    ::close(fd);
+    return false;
+  }
+  // owns the fd, on the loop as long as the handler
+  ticker_ = detail::createWaitEvent(
+      fd, kTickerTimeout, acc::make_unique<NotifyTransportFactory>());
+  ticker_->setState(acc::EventBase::kToRead);
+  loop_->addEvent(ticker_.get());
+  acc::Singleton<SharedTimingWheel>::get()->addDriver();
+  return true;
+}
+
+bool EventHandler::startWaker() {
+  int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd == -1) {
+    ACCPLOG(ERROR) << "eventfd failed";
+    return false;
+  }
+  waker_ = detail::createWaitEvent(
+      fd, kTickerTimeout, acc::make_unique<NotifyTransportFactory>());
+  waker_->setState(acc::EventBase::kToRead);
+  loop_->addEvent(waker_.get());
+  return true;
+}
+
 } // namespace rdd
@@ -16,15 +16,37 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "accelerator/event/EventHandlerBase.h"
 #include "accelerator/event/EventLoop.h"
+#include "raster/net/TimingWheel.h"
 
 namespace rdd {
 
+class Event;
+
+/*
+ * Handler of the events of a loop.
+ *
+ * An event is armed on the loop's timing wheel to its deadline when it
+ * is dispatched to wait (an accepted connection, a connection waiting
+ * for the next request or response) and when a read or write returns
+ * EAGAIN, so a silent peer is timed out on time.  A server connection
+ * waiting for the next request is reaped after the idle timeout of its
+ * service.  The wheel is driven by a timerfd event of
+ * FLAGS_net_timer_tick, started with the handler, which also advances
+ * the SharedTimingWheel and the ZeroCopyReaper.
+ *
+ * A fd wait completes at its first readiness, so it never sees EAGAIN;
+ * it goes to the loop through addWaitEvent and is armed as it is added.
+ */
 class EventHandler : public acc::EventHandlerBase {
  public:
-  EventHandler(acc::EventLoop* loop) : loop_(loop) {}
-  virtual ~EventHandler() {}
+  EventHandler(acc::EventLoop* loop);
+  virtual ~EventHandler();
 
   void onConnect(acc::EventBase* event) override;
   void onListen(acc::EventBase* event) override;
@@ -33,11 +55,26 @@ class EventHandler : public acc::EventHandlerBase {
   void onTimeout(acc::EventBase* event) override;
   void close(acc::EventBase* event) override;
 
+  // add a fd wait to the loop from any thread, false if no handler of it
+  static bool addWaitEvent(acc::EventLoop* loop, Event* event);
+
  private:
   void onComplete(acc::EventBase* event);
   void onError(acc::EventBase* event);
 
+  void armTimer(Event* event);
+  void onTimer(Event* event);
+  void onTick();
+  bool startTicker();
+  bool startWaker();
+  void onWake();
+
   acc::EventLoop* loop_;
+  TimingWheel wheel_;
+  std::unique_ptr<Event> ticker_;
+  std::unique_ptr<Event> waker_;
+  std::mutex waitsLock_;
+  std::vector<Event*> waits_;
 };
 
 } // namespace rdd
@@ -16,39 +16,268 @@
 
 #include "raster/net/EventPool.h"
 
+#include <chrono>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+#include "raster/net/Channel.h"
+#include "raster/net/FiberIO.h"
+
 namespace rdd {
 
-std::unique_ptr<Event> EventPool::get(const Peer& peer) {
-  std::lock_guard<std::mutex> guard(lock_);
-  auto& q = pool_[peer];
-  if (!q.empty()) {
-    auto event = std::move(q.back());
-    q.pop_back();
-    return event;
+using acc::SharedMutex;
+
+namespace {
+
+const uint64_t kMaintainInterval = 1000000;
+
+}
+
+constexpr size_t EventPool::kShards;
+
+EventPool::EventPool(const Peer& peer, const PoolOption& option)
+  : peer_(peer), option_(option), label_(std::to_string(peer.port())) {
+}
+
+size_t EventPool::localShard() {
+  static std::atomic<size_t> next(0);
+  static __thread int shard = -1;
+  if (shard < 0) {
+    shard = next++ % kShards;
+  }
+  return shard;
+}
+
+bool EventPool::expired(const Item& item, uint64_t now) const {
+  return (option_.idleTimeout > 0 &&
+          now - item.idleTime > option_.idleTimeout) ||
+         (option_.maxLifetime > 0 &&
+          now - item.event->createTime() > option_.maxLifetime);
+}
+
+std::unique_ptr<Event> EventPool::get() {
+  size_t i = localShard();
+  uint64_t now = acc::timestampNow();
+  for (size_t k = 0; k < kShards; ++k) {
+    Shard& shard = shards_[(i + k) % kShards];
+    std::unique_lock<acc::SpinLock> lock(shard.lock, std::defer_lock);
+    if (k == 0) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      continue;
+    }
+    while (!shard.items.empty()) {
+      Item item = std::move(shard.items.back());
+      shard.items.pop_back();
+      if (expired(item, now)) {
+        ACCMON_CNT("pool.evict-" + label_);
+        --total_;
+        continue;
+      }
+      lock.unlock();
+      if (item.event->socket()->isConnected()) {
+        ACCMON_CNT("pool.hit-" + label_);
+        return std::move(item.event);
+      }
+      ACCMON_CNT("pool.evict-" + label_);
+      --total_;
+      if (k == 0) {
+        lock.lock();
+      } else if (!lock.try_lock()) {
+        break;
+      }
+    }
   }
+  ACCMON_CNT("pool.miss-" + label_);
   return nullptr;
 }
 
 void EventPool::giveBack(std::unique_ptr<Event> event) {
+  put(localShard(), std::move(event));
+}
+
+void EventPool::put(size_t i, std::unique_ptr<Event> event) {
+  uint64_t now = acc::timestampNow();
+  if (option_.maxLifetime > 0 &&
+      now - event->createTime() > option_.maxLifetime) {
+    ACCMON_CNT("pool.evict-" + label_);
+    --total_;
+    return;
+  }
+  Shard& shard = shards_[i];
+  acc::SpinLockGuard guard(shard.lock);
+  shard.items.push_back({std::move(event), now});
+}
+
+bool EventPool::acquire() {
+  size_t n = ++total_;
+  if (option_.maxTotal > 0 && n > option_.maxTotal) {
+    --total_;
+    ACCMON_CNT("pool.exhausted-" + label_);
+    return false;
+  }
+  return true;
+}
+
+void EventPool::release() {
+  --total_;
+}
+
+void EventPool::setChannel(std::shared_ptr<Channel> channel) {
   std::lock_guard<std::mutex> guard(lock_);
-  pool_[event->peer()].push_back(std::move(event));
+  if (!channel_) {
+    channel_ = channel;
+  }
 }
 
-size_t EventPool::count() const {
+std::unique_ptr<Event> EventPool::connect() {
+  auto socket = Socket::createAsyncSocket();
+  if (!socket ||
+      !socket->setKeepAlive() ||
+      !socket->connect(peer_) ||
+      !waitWritable(socket->fd(), channel_->timeoutOption().ctimeout)) {
+    return nullptr;
+  }
+  int err = 1;
+  if (!socket->getError(err) || err != 0) {
+    ACCLOG(WARN) << "peer[" << peer_ << "] warmup connect failed";
+    return nullptr;
+  }
+  return acc::make_unique<Event>(channel_, std::move(socket));
+}
+
+size_t EventPool::warmup() {
   std::lock_guard<std::mutex> guard(lock_);
+  if (!channel_) {
+    return 0;
+  }
   size_t n = 0;
-  for (auto& kv : pool_) {
-    n += kv.second.size();
+  size_t idle = count();
+  // spread over the shards, they are taken by different threads
+  for (size_t i = 0; idle + n < option_.minIdle; ++i) {
+    if (!acquire()) {
+      break;
+    }
+    auto event = connect();
+    if (!event) {
+      release();
+      break;
+    }
+    put((localShard() + i) % kShards, std::move(event));
+    ++n;
+  }
+  if (n > 0) {
+    ACCLOG(INFO) << "peer[" << peer_ << "] warmup " << n << " connections";
+    ACCMON_AVG("pool.warmup-" + label_, n);
   }
   return n;
 }
 
-EventPool* EventPoolManager::getPool(int id) {
-  std::lock_guard<std::mutex> guard(lock_);
-  if (pool_.find(id) == pool_.end()) {
-    pool_.emplace(id, acc::make_unique<EventPool>());
+void EventPool::maintain() {
+  uint64_t now = acc::timestampNow();
+  bool probe = option_.probeInterval > 0 &&
+    now - probeTime_ >= option_.probeInterval;
+  if (probe) {
+    probeTime_ = now;
+  }
+  for (auto& shard : shards_) {
+    std::vector<Item> items;
+    {
+      acc::SpinLockGuard guard(shard.lock);
+      items.swap(shard.items);
+    }
+    // probe out of the lock, get() on this shard misses meanwhile
+    std::vector<Item> alive;
+    for (auto& item : items) {
+      if (expired(item, now) ||
+          (probe && !item.event->socket()->isIdle())) {
+        ACCMON_CNT("pool.evict-" + label_);
+        --total_;
+      } else {
+        alive.push_back(std::move(item));
+      }
+    }
+    if (!alive.empty()) {
+      acc::SpinLockGuard guard(shard.lock);
+      for (auto& item : alive) {
+        shard.items.push_back(std::move(item));
+      }
+    }
+  }
+  warmup();
+}
+
+size_t EventPool::count() const {
+  size_t n = 0;
+  for (auto& shard : shards_) {
+    acc::SpinLockGuard guard(shard.lock);
+    n += shard.items.size();
+  }
+  return n;
+}
+
+EventPoolManager::~EventPoolManager() {
+  stop();
+}
+
+EventPool* EventPoolManager::getPool(const Peer& peer,
+                                     const PoolOption& option) {
+  {
+    SharedMutex::ReadHolder guard(lock_);
+    auto it = pool_.find(peer);
+    if (it != pool_.end()) {
+      return it->second.get();
+    }
+  }
+  SharedMutex::WriteHolder guard(lock_);
+  auto& pool = pool_[peer];
+  if (!pool) {
+    pool = acc::make_unique<EventPool>(peer, option);
+    if (option.enabled()) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!thread_.joinable() && !stop_) {
+        thread_ = std::thread([this]() { loop(); });
+      }
+    }
+  }
+  return pool.get();
+}
+
+void EventPoolManager::stop() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+    cond_.notify_all();
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void EventPoolManager::loop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait_for(lock, std::chrono::microseconds(kMaintainInterval),
+                     [this]() { return stop_; });
+      if (stop_) {
+        break;
+      }
+    }
+    std::vector<EventPool*> pools;
+    {
+      SharedMutex::ReadHolder guard(lock_);
+      for (auto& kv : pool_) {
+        if (kv.second->option().enabled()) {
+          pools.push_back(kv.second.get());
+        }
+      }
+    }
+    for (auto pool : pools) {
+      pool->maintain();
+    }
   }
-  return pool_[id].get();
 }
 
 } // namespace rdd
@@ -16,40 +16,116 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "accelerator/thread/SharedMutex.h"
+#include "accelerator/thread/SpinLock.h"
 #include "raster/net/Event.h"
 #include "raster/net/NetUtil.h"
 
 namespace rdd {
 
+class Channel;
+
+/*
+ * Keep-alive connections of a peer, idle ones sharded by thread.
+ *
+ * A thread gives connections back to its own shard and gets from it
+ * first, so the shard lock is uncontended in the common case.  On a miss
+ * it steals from other shards, skipping the busy ones by try_lock.
+ *
+ * With a PoolOption the pool caps the connections, drops idle ones out
+ * of their idle time or lifetime, probes them, and keeps minIdle ones
+ * (made by warmup() and refilled by maintain()).
+ */
 class EventPool {
  public:
-  EventPool() {}
+  static constexpr size_t kShards = 16;
 
-  std::unique_ptr<Event> get(const Peer& peer);
+  EventPool(const Peer& peer, const PoolOption& option);
+
+  // nullptr if no live idle connection
+  std::unique_ptr<Event> get();
 
   void giveBack(std::unique_ptr<Event> event);
 
-  size_t count() const;
+  // Take a slot for a new connection, false if at maxTotal.
+  bool acquire();
+  // Give back the slot of a connection not given back.
+  void release();
+
+  // Channel of the connections made by the pool, the first one is kept.
+  void setChannel(std::shared_ptr<Channel> channel);
+
+  // Connect up to minIdle idle connections, blocking.
+  size_t warmup();
+
+  // Drop expired and dead idle connections, then warmup.
+  void maintain();
+
+  const PoolOption& option() const { return option_; }
+
+  size_t count() const;  // idle
+  size_t total() const { return total_; }
 
  private:
-  std::unordered_map<Peer, std::vector<std::unique_ptr<Event>>> pool_;
-  mutable std::mutex lock_;
+  struct Item {
+    std::unique_ptr<Event> event;
+    uint64_t idleTime;
+  };
+
+  struct Shard {
+    std::vector<Item> items;
+    mutable acc::SpinLock lock;
+    char pad[64];  // no false sharing between shards
+  };
+
+  static size_t localShard();
+
+  bool expired(const Item& item, uint64_t now) const;
+  void put(size_t i, std::unique_ptr<Event> event);
+  std::unique_ptr<Event> connect();
+
+  Peer peer_;
+  PoolOption option_;
+  std::string label_;
+  Shard shards_[kShards];
+  std::atomic<size_t> total_{0};
+  uint64_t probeTime_{0};
+
+  std::mutex lock_;  // of channel_ and warmup
+  std::shared_ptr<Channel> channel_;
 };
 
 class EventPoolManager {
  public:
   EventPoolManager() {}
+  ~EventPoolManager();
+
+  // The option is taken by the first call of a peer.
+  EventPool* getPool(const Peer& peer,
+                     const PoolOption& option = PoolOption());
 
-  EventPool* getPool(int id);
+  void stop();
 
  private:
-  std::unordered_map<int, std::unique_ptr<EventPool>> pool_;
-  mutable std::mutex lock_;
+  void loop();
+
+  std::unordered_map<Peer, std::unique_ptr<EventPool>> pool_;
+  acc::SharedMutex lock_;
+
+  // maintainer of the pools with option
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stop_{false};
 };
 
 } // namespace rdd
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "raster/coroutine/Fiber.h"
+#include "raster/coroutine/FreeList.h"
 #include "raster/net/Event.h"
 #include "raster/net/Processor.h"
 
@@ -30,11 +31,23 @@ class EventTask : public Fiber::Task {
 
   ~EventTask() override {}
 
+  static void* operator new(size_t size) {
+    return FreeList<EventTask>::allocate(size);
+  }
+  static void operator delete(void* p, size_t size) {
+    FreeList<EventTask>::deallocate(p, size);
+  }
+
   void handle() override {
     event_->processor()->run();
     event_->setState(Event::kToWrite);
   }
 
+  void drop() override {
+    event_->processor()->reject();
+    event_->setState(Event::kToWrite);
+  }
+
   Event* event() const { return event_; }
 
  private:
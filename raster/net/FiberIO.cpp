@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/FiberIO.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "accelerator/Logging.h"
+#include "raster/coroutine/FiberManager.h"
+#include "raster/net/Channel.h"
+#include "raster/net/NetHub.h"
+#include "raster/net/NotifyTransport.h"
+
+namespace rdd {
+
+namespace {
+
+bool waitInThread(int fd, bool write, uint64_t timeout) {
+  struct pollfd pfd = {};
+  pfd.fd = fd;
+  pfd.events = write ? POLLOUT : POLLIN;
+  int ms = (timeout + 999) / 1000;
+  while (true) {
+    int r = ::poll(&pfd, 1, ms);
+    if (r > 0) {
+      return !(pfd.revents & POLLNVAL);
+    }
+    if (r == 0) {
+      return false;
+    }
+    if (errno != EINTR) {
+      ACCPLOG(ERROR) << "fd(" << fd << "): poll failed";
+      return false;
+    }
+  }
+}
+
+bool waitFd(int fd, bool write, uint64_t timeout) {
+  struct stat st;
+  if (::fstat(fd, &st) == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd << "): fstat failed";
+    return false;
+  }
+  // epoll does not take regular files
+  if (S_ISREG(st.st_mode)) {
+    return true;
+  }
+  Fiber* fiber = FiberManager::get();
+  NetHub* hub = fiber ? dynamic_cast<NetHub*>(fiber->task()->hub) : nullptr;
+  if (!hub) {
+    return waitInThread(fd, write, timeout);
+  }
+  auto event = detail::createWaitEvent(
+      fd, timeout, acc::make_unique<WaitTransportFactory>());
+  if (write) {
+    event->setState(Event::kToWrite);
+    event->setOneway();
+  } else {
+    event->setState(Event::kToRead);
+  }
+  char detail[16];
+  snprintf(detail, sizeof(detail), "%d %c", fd, write ? 'w' : 'r');
+  fiber->setWait(Fiber::kWaitIO, detail);
+  hub->waitEvent(fiber, event.get());
+  bool ready = event->state() == Event::kReaded ||
+               event->state() == Event::kWrited;
+  event->socket()->release();
+  return ready;
+}
+
+}
+
+bool waitReadable(int fd, uint64_t timeout) {
+  return waitFd(fd, false, timeout);
+}
+
+bool waitWritable(int fd, uint64_t timeout) {
+  return waitFd(fd, true, timeout);
+}
+
+namespace detail {
+
+std::unique_ptr<Event> createWaitEvent(
+    int fd,
+    uint64_t timeout,
+    std::unique_ptr<TransportFactory> transportFactory) {
+  TimeoutOption timeoutOpt;
+  timeoutOpt.ctimeout = timeout;
+  timeoutOpt.rtimeout = timeout;
+  timeoutOpt.wtimeout = timeout;
+  auto channel = std::make_shared<Channel>(
+      Peer(), timeoutOpt, std::move(transportFactory));
+  // client role: a failed event is closed back to the hub, not deleted
+  auto event = acc::make_unique<Event>(
+      channel, acc::make_unique<Socket>(fd, Peer(), Socket::kClient));
+  event->setFdWait();
+  return event;
+}
+
+} // namespace detail
+
+} // namespace rdd
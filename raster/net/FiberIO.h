@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace rdd {
+
+class Event;
+class TransportFactory;
+
+/*
+ * Wait for any fd (pipe, eventfd, timerfd, inotify, socket) to be
+ * readable or writable in a fiber without blocking its thread.
+ *
+ * The fd is carried by a client-role Event on the event loop of the
+ * fiber's NetHub, which resumes the fiber when it is ready or times
+ * out.  The fd is not read, written or closed.  Regular files are always
+ * ready.  Out of a fiber it polls the thread.  Times are in microseconds.
+ *
+ * Return true if ready, false on timeout or error.
+ */
+bool waitReadable(int fd, uint64_t timeout);
+bool waitWritable(int fd, uint64_t timeout);
+
+namespace detail {
+
+// Client-role fd wait event with all its timeouts set to timeout.
+std::unique_ptr<Event> createWaitEvent(
+    int fd,
+    uint64_t timeout,
+    std::unique_ptr<TransportFactory> transportFactory);
+
+} // namespace detail
+
+} // namespace rdd
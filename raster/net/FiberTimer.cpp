@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/net/FiberTimer.h"
+
+#include <chrono>
+#include <sys/timerfd.h>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Singleton.h"
+#include "accelerator/Time.h"
+#include "raster/coroutine/FiberManager.h"
+#include "raster/net/FiberIO.h"
+#include "raster/net/NetHub.h"
+#include "raster/net/NotifyTransport.h"
+
+namespace rdd {
+
+namespace {
+
+// the event is only a carrier, its own timeout must not fire first
+const uint64_t kTimeoutMargin = 1000000;
+
+bool setTimer(int fd, uint64_t timeout) {
+  struct itimerspec its = {};
+  if (timeout == 0) {
+    its.it_value.tv_nsec = 1;  // 0 disarms
+  } else {
+    its.it_value.tv_sec = timeout / 1000000;
+    its.it_value.tv_nsec = timeout % 1000000 * 1000;
+  }
+  if (::timerfd_settime(fd, 0, &its, nullptr) == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd << "): timerfd_settime failed";
+    return false;
+  }
+  return true;
+}
+
+}
+
+bool FiberTimer::waitFor(uint64_t timeout) {
+  if (cancelled_) {
+    return false;
+  }
+  Fiber* fiber = FiberManager::get();
+  return fiber ? waitInFiber(fiber, timeout) : waitInThread(timeout);
+}
+
+bool FiberTimer::waitUntil(uint64_t deadline) {
+  uint64_t now = acc::timestampNow();
+  return waitFor(deadline > now ? deadline - now : 0);
+}
+
+void FiberTimer::cancel() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  cancelled_ = true;
+  if (fd_ != -1) {
+    setTimer(fd_, 0);
+  }
+  // false if it has fired, which posts
+  if (waiting_ &&
+      acc::Singleton<SharedTimingWheel>::get()->cancel(&timer_)) {
+    baton_.post();
+  }
+  cond_.notify_all();
+}
+
+bool FiberTimer::waitInFiber(Fiber* fiber, uint64_t timeout) {
+  auto wheel = acc::Singleton<SharedTimingWheel>::get();
+  if (timeout < wheel->tick() || !wheel->driven()) {
+    return waitOnLoop(fiber, timeout);
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (cancelled_) {
+      return false;
+    }
+    baton_.reset();
+    timer_.callback = [this]() { baton_.post(); };
+    wheel->schedule(&timer_, timeout);
+    waiting_ = true;
+  }
+  baton_.wait("timer", Fiber::kWaitTimer);
+  // waits out a callback still running, the timer may go after return
+  wheel->cancel(&timer_);
+  std::lock_guard<std::mutex> guard(mutex_);
+  waiting_ = false;
+  return !cancelled_;
+}
+
+bool FiberTimer::waitOnLoop(Fiber* fiber, uint64_t timeout) {
+  NetHub* hub = dynamic_cast<NetHub*>(fiber->task()->hub);
+  if (!hub) {
+    ACCLOG(WARN) << *fiber << " is not scheduled by NetHub, block thread";
+    return waitInThread(timeout);
+  }
+  int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd == -1) {
+    ACCPLOG(ERROR) << "timerfd_create failed";
+    return false;
+  }
+  auto event = detail::createWaitEvent(
+      fd, timeout + kTimeoutMargin,
+      acc::make_unique<NotifyTransportFactory>());
+  event->setState(Event::kToRead);
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!setTimer(fd, cancelled_ ? 0 : timeout)) {
+      return false;
+    }
+    fd_ = fd;
+  }
+  fiber->setWait(Fiber::kWaitTimer, "timerfd");
+  hub->waitEvent(fiber, event.get());
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    fd_ = -1;
+  }
+  return !cancelled_;
+}
+
+bool FiberTimer::waitInThread(uint64_t timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait_for(lock, std::chrono::microseconds(timeout),
+                 [&]() { return cancelled_.load(); });
+  return !cancelled_;
+}
+
+void fiberSleepFor(uint64_t timeout) {
+  FiberTimer timer;
+  timer.waitFor(timeout);
+}
+
+void fiberSleepUntil(uint64_t deadline) {
+  FiberTimer timer;
+  timer.waitUntil(deadline);
+}
+
+} // namespace rdd
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "raster/coroutine/FiberBaton.h"
+#include "raster/net/TimingWheel.h"
+
+namespace rdd {
+
+class Fiber;
+
+/*
+ * Timer to wait in a fiber without blocking its thread.
+ *
+ * The wait arms a timer on the SharedTimingWheel and yields, with no
+ * syscall; the fiber is resumed when the timer fires, rounded up to the
+ * tick.  A wait shorter than a tick, or before any loop ticks, arms a
+ * timerfd on the event loop of the fiber's NetHub instead.  Out of a
+ * fiber it blocks the thread.  Times are in microseconds.
+ */
+class FiberTimer {
+ public:
+  FiberTimer() {}
+
+  // Return false if cancelled.
+  bool waitFor(uint64_t timeout);
+  bool waitUntil(uint64_t deadline);  // as acc::timestampNow()
+
+  // Wake the waiter now, safe from any thread.  The timer keeps
+  // cancelled (later waits return at once) until reset().
+  void cancel();
+  void reset() { cancelled_ = false; }
+
+  bool cancelled() const { return cancelled_; }
+
+  FiberTimer(const FiberTimer&) = delete;
+  FiberTimer& operator=(const FiberTimer&) = delete;
+
+ private:
+  bool waitInFiber(Fiber* fiber, uint64_t timeout);
+  bool waitOnLoop(Fiber* fiber, uint64_t timeout);
+  bool waitInThread(uint64_t timeout);
+
+  std::atomic<bool> cancelled_{false};
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int fd_{-1};  // timerfd while waiting on loop
+  // on the SharedTimingWheel, posting baton_
+  TimingWheel::Timer timer_;
+  FiberBaton baton_;
+  bool waiting_{false};
+};
+
+void fiberSleepFor(uint64_t timeout);
+void fiberSleepUntil(uint64_t deadline);
+
+} // namespace rdd
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/Hedge.h"
+
+#include <algorithm>
+
+#include "accelerator/stats/Monitor.h"
+
+namespace rdd {
+
+constexpr size_t HedgePolicy::kSamples;
+constexpr size_t HedgePolicy::kUpdateInterval;
+constexpr double HedgePolicy::kMaxTokens;
+
+HedgePolicy::HedgePolicy(const std::string& name, const HedgeOption& option)
+  : name_(name), option_(option), delay_(option.delay) {
+  samples_.reserve(kSamples);
+}
+
+void HedgePolicy::addRequest() {
+  acc::SpinLockGuard guard(lock_);
+  tokens_ = std::min(tokens_ + option_.budget, kMaxTokens);
+}
+
+bool HedgePolicy::tryHedge() {
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (tokens_ >= 1) {
+      tokens_ -= 1;
+      return true;
+    }
+  }
+  ACCMON_CNT("hedge.over_budget-" + name_);
+  return false;
+}
+
+void HedgePolicy::addLatency(uint64_t latency) {
+  if (option_.delay > 0) {
+    return;
+  }
+  std::vector<uint64_t> samples;
+  {
+    acc::SpinLockGuard guard(lock_);
+    if (samples_.size() < kSamples) {
+      samples_.push_back(latency);
+    } else {
+      samples_[next_] = latency;
+      next_ = (next_ + 1) % kSamples;
+    }
+    if (++count_ % kUpdateInterval != 0) {
+      return;
+    }
+    samples = samples_;
+  }
+  // out of the lock, sort a copy
+  size_t i = samples.size() * std::min(option_.percentile, 100.0) / 100;
+  i = std::min(i, samples.size() - 1);
+  std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+  delay_ = std::max(samples[i], option_.minDelay);
+  ACCMON_AVG("hedge.delay-" + name_, delay_);
+}
+
+} // namespace rdd
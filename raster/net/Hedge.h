@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "accelerator/thread/SpinLock.h"
+
+namespace rdd {
+
+// Hedged requests, times in us.
+struct HedgeOption {
+  uint64_t delay{0};        // fixed hedge delay, 0 for the percentile
+  double percentile{95};    // of the recent latencies as the delay
+  uint64_t minDelay{1000};  // floor of the percentile delay
+  double budget{0.05};      // hedges per request at most
+};
+
+/*
+ * Decides when and whether a request is hedged: after the percentile
+ * latency of the recent requests it goes to another replica too, while
+ * hedges stay within budget of the requests.
+ *
+ * Shared by all the calls to a backend, thread safe.
+ */
+class HedgePolicy {
+ public:
+  HedgePolicy(const std::string& name, const HedgeOption& option);
+
+  const std::string& name() const { return name_; }
+
+  // Delay before a hedge, 0 if not known yet (no hedge).
+  uint64_t delay() const { return delay_; }
+
+  // Count a request and earn budget.
+  void addRequest();
+  // Spend budget of a hedge.
+  bool tryHedge();
+
+  void addLatency(uint64_t latency);
+
+ private:
+  static constexpr size_t kSamples = 1024;
+  static constexpr size_t kUpdateInterval = 64;
+  static constexpr double kMaxTokens = 10;
+
+  std::string name_;
+  HedgeOption option_;
+  std::atomic<uint64_t> delay_{0};
+
+  acc::SpinLock lock_;
+  double tokens_{0};
+  std::vector<uint64_t> samples_;
+  size_t next_{0};
+  size_t count_{0};
+};
+
+} // namespace rdd
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/LoadBalancer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "accelerator/Logging.h"
+#include "accelerator/stats/Monitor.h"
+
+namespace rdd {
+
+namespace {
+
+__thread uint64_t rngState = 0;
+
+uint64_t random64() {
+  if (rngState == 0) {
+    rngState = acc::timestampNow() ^ uint64_t(&rngState) ^ 0x9e3779b97f4a7c15;
+  }
+  // xorshift64*
+  rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return rngState * 0x2545f4914f6cdd1d;
+}
+
+}
+
+LoadBalancer::Replica::Replica(const std::string& address)
+  : addr(address) {
+  peer.setFromIpPort(addr);
+}
+
+double LoadBalancer::Replica::latency(uint64_t now, uint64_t decay) const {
+  acc::SpinLockGuard guard(lock);
+  if (now <= updated) {
+    return ewma;
+  }
+  return ewma * std::exp(-double(now - updated) / decay);
+}
+
+constexpr size_t LoadBalancer::kVirtualNodes;
+
+LoadBalancer::LoadBalancer(const std::string& name,
+                           Policy policy,
+                           uint64_t decay)
+  : name_(name),
+    policy_(policy),
+    decay_(std::max(decay, uint64_t(1))),
+    snapshot_(std::make_shared<Snapshot>()) {
+}
+
+void LoadBalancer::setReplicas(const std::vector<std::string>& addrs,
+                               const EjectOption& eject) {
+  std::unordered_map<std::string, std::shared_ptr<Replica>> old;
+  for (auto& replica : snapshot()->replicas) {
+    old.emplace(replica->addr, replica);
+  }
+  auto snap = std::make_shared<Snapshot>();
+  snap->eject = eject;
+  for (auto& addr : addrs) {
+    auto it = old.find(addr);
+    snap->replicas.push_back(
+        it != old.end() ? it->second : std::make_shared<Replica>(addr));
+  }
+  if (policy_ == kHash) {
+    for (size_t i = 0; i < snap->replicas.size(); ++i) {
+      for (size_t j = 0; j < kVirtualNodes; ++j) {
+        auto node = snap->replicas[i]->addr + "#" + std::to_string(j);
+        snap->ring.emplace_back(hash(node), i);
+      }
+    }
+    std::sort(snap->ring.begin(), snap->ring.end());
+  }
+  {
+    acc::SharedMutex::WriteHolder guard(lock_);
+    snapshot_ = snap;
+  }
+  ACCLOG(INFO) << "balancer[" << name_ << "] set "
+    << addrs.size() << " replicas";
+}
+
+size_t LoadBalancer::count() const {
+  return snapshot()->replicas.size();
+}
+
+std::shared_ptr<LoadBalancer::Replica> LoadBalancer::pick(uint64_t key) {
+  auto snap = snapshot();
+  auto& replicas = snap->replicas;
+  size_t n = replicas.size();
+  if (n == 0) {
+    ACCLOG(WARN) << "balancer[" << name_ << "] has no replica";
+    return nullptr;
+  }
+  uint64_t now = acc::timestampNow();
+  size_t i = policy_ == kHash ? pickHash(*snap, key, now) : pickP2C(*snap, now);
+  ++replicas[i]->inflight;
+  return replicas[i];
+}
+
+std::shared_ptr<LoadBalancer::Replica>
+LoadBalancer::pick(const std::string& key) {
+  return pick(hash(key));
+}
+
+size_t LoadBalancer::pickP2C(const Snapshot& snap, uint64_t now) {
+  auto& replicas = snap.replicas;
+  size_t n = replicas.size();
+  if (n == 1) {
+    return 0;
+  }
+  auto ejected = [&](size_t k) {
+    return replicas[k]->ejectedUntil.load(std::memory_order_relaxed) > now;
+  };
+  // two distinct choices, resampled a few times around ejected ones
+  size_t a = 0, b = 1;
+  for (size_t tries = 0; tries < 2 * n; ++tries) {
+    a = random64() % n;
+    b = random64() % (n - 1);
+    if (b >= a) {
+      ++b;
+    }
+    if (ejected(a) && !ejected(b)) {
+      return b;
+    }
+    if (!ejected(a) && ejected(b)) {
+      return a;
+    }
+    if (!ejected(a)) {
+      break;
+    }
+  }
+  // both ejected means nearly all are, fail open
+  auto score = [&](size_t k) {
+    return replicas[k]->latency(now, decay_) * (replicas[k]->inflight + 1);
+  };
+  return score(b) < score(a) ? b : a;
+}
+
+size_t LoadBalancer::pickHash(const Snapshot& snap,
+                              uint64_t key,
+                              uint64_t now) {
+  auto& ring = snap.ring;
+  auto it = std::lower_bound(ring.begin(), ring.end(),
+                             std::make_pair(key, size_t(0)));
+  size_t start = it != ring.end() ? it - ring.begin() : 0;
+  // the next node of a live replica, keys of the others stay put
+  for (size_t j = 0; j < ring.size(); ++j) {
+    size_t i = ring[(start + j) % ring.size()].second;
+    if (snap.replicas[i]->ejectedUntil.load(std::memory_order_relaxed)
+        <= now) {
+      return i;
+    }
+  }
+  return ring[start].second;
+}
+
+void LoadBalancer::done(const std::shared_ptr<Replica>& replica,
+                        uint64_t latency,
+                        bool ok,
+                        uint64_t timeout) {
+  --replica->inflight;
+  if (!ok) {
+    ACCMON_CNT("balancer.fail-" + name_);
+    latency = std::max(latency, timeout);
+  }
+  uint64_t now = acc::timestampNow();
+  acc::SpinLockGuard guard(replica->lock);
+  if (replica->updated == 0 || latency > replica->ewma) {
+    // peak sensitive: a slowdown shows at once, recovery decays
+    replica->ewma = latency;
+  } else {
+    double w = std::exp(-double(now - replica->updated) / decay_);
+    replica->ewma = replica->ewma * w + latency * (1 - w);
+  }
+  replica->updated = now;
+  if (ok) {
+    replica->failures = 0;
+    if (replica->ejectedUntil.load(std::memory_order_relaxed) <= now) {
+      replica->ejections = 0;
+    }
+  } else {
+    ++replica->failures;
+    auto snap = snapshot();
+    if (snap->eject.failures > 0 &&
+        replica->failures >= snap->eject.failures &&
+        replica->ejectedUntil.load(std::memory_order_relaxed) <= now) {
+      eject(*snap, *replica, now);
+    }
+  }
+}
+
+void LoadBalancer::eject(const Snapshot& snap,
+                         Replica& replica,
+                         uint64_t now) {
+  size_t ejected = 0;
+  for (auto& r : snap.replicas) {
+    if (r->ejectedUntil.load(std::memory_order_relaxed) > now) {
+      ++ejected;
+    }
+  }
+  if (ejected + 1 > snap.replicas.size() * snap.eject.maxPercent / 100) {
+    return;
+  }
+  // backs off on a replica failing again after its return
+  replica.ejections = std::min(replica.ejections + 1, size_t(10));
+  replica.failures = 0;
+  replica.ejectedUntil.store(now + snap.eject.time * replica.ejections,
+                             std::memory_order_relaxed);
+  ACCLOG(WARN) << "balancer[" << name_ << "] eject " << replica.addr
+    << " for " << snap.eject.time * replica.ejections << "us";
+  ACCMON_CNT("balancer.eject-" + name_);
+}
+
+uint64_t LoadBalancer::hash(const std::string& s) {
+  // FNV-1a, then mixed as murmur3 fmix64 for the ring spread
+  uint64_t h = 0xcbf29ce484222325;
+  for (unsigned char c : s) {
+    h = (h ^ c) * 0x100000001b3;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+
+std::shared_ptr<LoadBalancer::Snapshot> LoadBalancer::snapshot() const {
+  acc::SharedMutex::ReadHolder guard(lock_);
+  return snapshot_;
+}
+
+void LoadBalancerManager::setupBalancer(const std::string& name,
+                                        LoadBalancer::Policy policy,
+                                        const std::vector<std::string>& addrs,
+                                        uint64_t decay,
+                                        const EjectOption& eject) {
+  std::shared_ptr<LoadBalancer> balancer;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto& p = balancers_[name];
+    if (!p) {
+      p = std::make_shared<LoadBalancer>(name, policy, decay);
+    }
+    balancer = p;
+  }
+  balancer->setReplicas(addrs, eject);
+}
+
+std::shared_ptr<LoadBalancer>
+LoadBalancerManager::getBalancer(const std::string& name) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = balancers_.find(name);
+  return it != balancers_.end() ? it->second : nullptr;
+}
+
+} // namespace rdd
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "accelerator/Time.h"
+#include "accelerator/thread/SharedMutex.h"
+#include "accelerator/thread/SpinLock.h"
+#include "raster/net/NetUtil.h"
+
+namespace rdd {
+
+// Outlier ejection of replicas, times in us.
+struct EjectOption {
+  size_t failures{5};         // consecutive to eject, 0 for no ejection
+  uint64_t time{30000000};    // ejected, times # of consecutive ejections
+  double maxPercent{50};      // of the replicas ejected at most
+};
+
+/*
+ * Chooses a replica of a backend per request.
+ *
+ * kP2C takes the better of two random replicas by EWMA latency times
+ * (in-flight + 1), so slow or busy replicas get less load.  kHash maps
+ * a key to a replica by a consistent hash ring, for cache-affine
+ * backends; only the keys of a removed or added replica move.
+ *
+ * A replica failing consecutively is ejected (not picked) for a while,
+ * longer on each ejection in a row, if not too many are ejected.
+ *
+ * The replicas are replaced by setReplicas() (config reload), the stats
+ * of the kept ones stay.  Thread safe.
+ */
+class LoadBalancer {
+ public:
+  enum Policy {
+    kP2C,
+    kHash,
+  };
+
+  struct Replica {
+    explicit Replica(const std::string& addr);
+
+    // EWMA decayed to now, so an unpicked slow replica is tried again
+    double latency(uint64_t now, uint64_t decay) const;
+
+    std::string addr;       // ip:port
+    Peer peer;
+    std::atomic<int> inflight{0};
+
+    std::atomic<uint64_t> ejectedUntil{0};
+
+    mutable acc::SpinLock lock;
+    double ewma{0};         // latency in us
+    uint64_t updated{0};
+    size_t failures{0};     // consecutive
+    size_t ejections{0};    // consecutive
+  };
+
+  LoadBalancer(const std::string& name,
+               Policy policy,
+               uint64_t decay = 10000000);
+
+  const std::string& name() const { return name_; }
+
+  void setReplicas(const std::vector<std::string>& addrs,
+                   const EjectOption& eject = EjectOption());
+  size_t count() const;
+
+  // Pick a replica and count it in flight, nullptr if none.  The key
+  // is for kHash.
+  std::shared_ptr<Replica> pick(uint64_t key = 0);
+  std::shared_ptr<Replica> pick(const std::string& key);
+
+  // The call to a picked replica is done, a failure counts as timeout.
+  void done(const std::shared_ptr<Replica>& replica,
+            uint64_t latency,
+            bool ok,
+            uint64_t timeout);
+
+  static uint64_t hash(const std::string& s);
+
+ private:
+  // replicas and the hash ring, replaced as a whole
+  struct Snapshot {
+    std::vector<std::shared_ptr<Replica>> replicas;
+    std::vector<std::pair<uint64_t, size_t>> ring;
+    EjectOption eject;
+  };
+
+  static constexpr size_t kVirtualNodes = 128;
+
+  std::shared_ptr<Snapshot> snapshot() const;
+
+  size_t pickP2C(const Snapshot& snap, uint64_t now);
+  size_t pickHash(const Snapshot& snap, uint64_t key, uint64_t now);
+  void eject(const Snapshot& snap, Replica& replica, uint64_t now);
+
+  std::string name_;
+  Policy policy_;
+  uint64_t decay_;  // time constant (us) of the EWMA
+
+  std::shared_ptr<Snapshot> snapshot_;
+  mutable acc::SharedMutex lock_;
+};
+
+class LoadBalancerManager {
+ public:
+  LoadBalancerManager() {}
+
+  // Create or update, the policy of an existing one is kept.
+  void setupBalancer(const std::string& name,
+                     LoadBalancer::Policy policy,
+                     const std::vector<std::string>& addrs,
+                     uint64_t decay,
+                     const EjectOption& eject = EjectOption());
+
+  std::shared_ptr<LoadBalancer> getBalancer(const std::string& name);
+
+ private:
+  std::map<std::string, std::shared_ptr<LoadBalancer>> balancers_;
+  std::mutex lock_;
+};
+
+/*
+ * AsyncClient over a LoadBalancer: each fetch picks a replica, calls it
+ * by a new C and reports the latency back.
+ */
+template <class C>
+class BalancedClient {
+ public:
+  BalancedClient(std::shared_ptr<LoadBalancer> balancer,
+                 const ClientOption& option)
+    : balancer_(balancer), option_(option) {}
+
+  // Key of the next calls for kHash.
+  void setKey(uint64_t key) { key_ = key; }
+
+  template <class... Args>
+  bool fetch(Args&&... args) {
+    auto replica = balancer_->pick(key_);
+    if (!replica) {
+      return false;
+    }
+    ClientOption option = option_;
+    option.peer = replica->peer;
+    uint64_t start = acc::timestampNow();
+    C client(option);
+    bool ok = client.connect() && client.fetch(std::forward<Args>(args)...);
+    auto& timeout = option_.timeout;
+    balancer_->done(replica, acc::timePassed(start), ok,
+                    timeout.ctimeout + timeout.rtimeout + timeout.wtimeout);
+    return ok;
+  }
+
+ private:
+  std::shared_ptr<LoadBalancer> balancer_;
+  ClientOption option_;
+  uint64_t key_{0};
+};
+
+} // namespace rdd
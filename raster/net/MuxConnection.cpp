@@ -0,0 +1,330 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/MuxConnection.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/Fiber.h"
+#include "raster/net/FiberIO.h"
+
+namespace rdd {
+
+constexpr uint64_t MuxConnection::kLeadSlice;
+constexpr uint32_t MuxConnection::kMaxFrameSize;
+
+std::shared_ptr<MuxConnection> MuxConnection::get(
+    const Peer& peer, const TimeoutOption& timeout, IdFunc idFunc) {
+  static std::mutex lock;
+  static std::unordered_map<Peer, std::shared_ptr<MuxConnection>> conns;
+  std::lock_guard<std::mutex> guard(lock);
+  auto& conn = conns[peer];
+  if (!conn || conn->broken()) {
+    conn = std::make_shared<MuxConnection>(peer, timeout, std::move(idFunc));
+  }
+  return conn;
+}
+
+MuxConnection::MuxConnection(const Peer& peer,
+                             const TimeoutOption& timeout,
+                             IdFunc idFunc)
+  : peer_(peer),
+    timeout_(timeout),
+    idFunc_(std::move(idFunc)),
+    label_(std::to_string(peer.port())) {
+}
+
+bool MuxConnection::call(int32_t id,
+                         const std::string& request,
+                         std::string& response,
+                         const TimeoutOption& timeout) {
+  uint64_t start = acc::timestampNow();
+  Waiter w;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (broken_) {
+      return false;
+    }
+    waiters_[id] = &w;
+    ACCMON_AVG("mux.inflight-" + label_, waiters_.size());
+  }
+
+  uint32_t n = htonl(request.size());
+  std::string frame((const char*)&n, sizeof(n));
+  frame += request;
+  if (!write(frame, start + timeout.wtimeout)) {
+    ACCLOG(WARN) << "peer[" << peer_ << "] mux write failed, id=" << id;
+    fail(&w);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    w.deadline = acc::timestampNow() + timeout.rtimeout;
+  }
+  while (true) {
+    bool leader = false;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      // once notified, a post is on the way to w: wait for it even if
+      // done, w is gone after the return
+      if (!w.notified) {
+        if (w.done) {
+          break;
+        }
+        if (!reading_) {
+          reading_ = true;
+          leader = true;
+        }
+      }
+    }
+    if (leader) {
+      lead(&w);
+      {
+        std::lock_guard<std::mutex> guard(lock_);
+        reading_ = false;
+        if (!w.done) {
+          waiters_.erase(id);
+          w.done = true;
+        }
+      }
+      handOver();
+      continue;
+    }
+    // posted when done, or to take over the reading
+    w.baton.wait("mux", Fiber::kWaitBackend);
+    w.baton.reset();
+    std::lock_guard<std::mutex> guard(lock_);
+    w.notified = false;
+  }
+
+  if (!w.ok) {
+    ACCLOG(WARN) << "peer[" << peer_ << "] mux call failed, id=" << id;
+    ACCMON_CNT("mux.fail-" + label_);
+    return false;
+  }
+  response = std::move(w.response);
+  return true;
+}
+
+bool MuxConnection::connect() {
+  auto socket = Socket::createAsyncSocket();
+  if (!socket ||
+      !socket->setTCPNoDelay() ||
+      !socket->connect(peer_) ||
+      !waitWritable(socket->fd(), timeout_.ctimeout)) {
+    return false;
+  }
+  int err = 1;
+  if (!socket->getError(err) || err != 0) {
+    return false;
+  }
+  socket_ = std::move(socket);
+  return true;
+}
+
+bool MuxConnection::write(const std::string& frame, uint64_t deadline) {
+  std::lock_guard<FiberMutex> guard(writeLock_);
+  if (broken_) {
+    return false;
+  }
+  if (!socket_ && !connect()) {
+    broken_ = true;
+    return false;
+  }
+  // a partial frame breaks the stream, so never give up in the middle
+  size_t off = 0;
+  while (off < frame.size()) {
+    ssize_t r = socket_->send(frame.data() + off, frame.size() - off);
+    if (r > 0) {
+      off += r;
+      continue;
+    }
+    uint64_t now = acc::timestampNow();
+    if (r != -2 || now >= deadline ||
+        !waitWritable(socket_->fd(), deadline - now)) {
+      broken_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MuxConnection::lead(Waiter* self) {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      if (self->done) {
+        return self->ok;
+      }
+    }
+    uint64_t now = acc::timestampNow();
+    uint64_t next = expire(self, now);
+    if (next == 0) {
+      return false;  // self timed out
+    }
+    // a caller may come with an earlier deadline meanwhile
+    uint64_t wait = std::min(next - now, kLeadSlice);
+    if (waitReadable(socket_->fd(), wait) && !readFrames(self)) {
+      fail(self);
+      return false;
+    }
+  }
+}
+
+uint64_t MuxConnection::expire(Waiter* self, uint64_t now) {
+  std::vector<Waiter*> notifies;
+  uint64_t next = 0;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (auto it = waiters_.begin(); it != waiters_.end(); ) {
+      Waiter* w = it->second;
+      if (w->deadline == 0 || w->deadline > now) {
+        if (w->deadline > 0 && (next == 0 || w->deadline < next)) {
+          next = w->deadline;
+        }
+        ++it;
+        continue;
+      }
+      it = waiters_.erase(it);
+      w->done = true;
+      w->ok = false;
+      if (w != self && !w->notified) {
+        w->notified = true;
+        notifies.push_back(w);
+      }
+    }
+    if (self->done) {
+      next = 0;
+    } else if (next == 0) {
+      next = now + kLeadSlice;  // only callers still writing
+    }
+  }
+  for (size_t i = 0; i < notifies.size(); ++i) {
+    ACCMON_CNT("mux.timeout-" + label_);
+  }
+  notify(notifies);
+  return next;
+}
+
+bool MuxConnection::readFrames(Waiter* self) {
+  char buf[16384];
+  while (true) {
+    ssize_t r = socket_->recv(buf, sizeof(buf));
+    if (r == -2) {
+      break;
+    }
+    if (r <= 0) {
+      ACCLOG(WARN) << "peer[" << peer_ << "] mux connection closed";
+      return false;
+    }
+    readBuf_.append(buf, r);
+  }
+  size_t off = 0;
+  while (readBuf_.size() - off >= sizeof(uint32_t)) {
+    uint32_t n = ntohl(*(const uint32_t*)(readBuf_.data() + off));
+    if (n > kMaxFrameSize) {
+      ACCLOG(WARN) << "peer[" << peer_ << "] mux frame too large: " << n;
+      return false;
+    }
+    if (readBuf_.size() - off - sizeof(n) < n) {
+      break;
+    }
+    dispatch(readBuf_.substr(off + sizeof(n), n), self);
+    off += sizeof(n) + n;
+  }
+  readBuf_.erase(0, off);
+  return true;
+}
+
+void MuxConnection::dispatch(std::string&& body, Waiter* self) {
+  int32_t id = idFunc_(body);
+  std::vector<Waiter*> notifies;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = waiters_.find(id);
+    if (it == waiters_.end()) {
+      // its caller has timed out
+      ACCLOG(WARN) << "peer[" << peer_ << "] mux drop response, id=" << id;
+      ACCMON_CNT("mux.drop-" + label_);
+      return;
+    }
+    Waiter* w = it->second;
+    waiters_.erase(it);
+    w->response = std::move(body);
+    w->done = true;
+    w->ok = true;
+    if (w != self && !w->notified) {
+      w->notified = true;
+      notifies.push_back(w);
+    }
+  }
+  notify(notifies);
+}
+
+void MuxConnection::handOver() {
+  std::vector<Waiter*> notifies;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (reading_) {
+      return;
+    }
+    for (auto& kv : waiters_) {
+      if (!kv.second->notified) {
+        kv.second->notified = true;
+        notifies.push_back(kv.second);
+        break;
+      }
+    }
+  }
+  notify(notifies);
+}
+
+void MuxConnection::fail(Waiter* self) {
+  std::vector<Waiter*> notifies;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    broken_ = true;
+    for (auto& kv : waiters_) {
+      Waiter* w = kv.second;
+      w->done = true;
+      w->ok = false;
+      if (w != self && !w->notified) {
+        w->notified = true;
+        notifies.push_back(w);
+      }
+    }
+    waiters_.clear();
+  }
+  if (socket_) {
+    // wake a leader parked on the fd
+    ::shutdown(socket_->fd(), SHUT_RDWR);
+  }
+  notify(notifies);
+}
+
+void MuxConnection::notify(std::vector<Waiter*>& waiters) {
+  // out of the lock, a waiter may be gone once posted
+  for (auto& w : waiters) {
+    w->baton.post();
+  }
+}
+
+} // namespace rdd
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "raster/coroutine/FiberBaton.h"
+#include "raster/coroutine/FiberMutex.h"
+#include "raster/net/NetUtil.h"
+#include "raster/net/Socket.h"
+
+namespace rdd {
+
+/*
+ * One backend connection shared by many fibers, with their requests in
+ * flight at once.
+ *
+ * Frames are length prefixed as BinaryTransport.  Each request carries an
+ * id which its response echoes (seqid for thrift), so responses may come
+ * in any order and are matched to the waiting callers by id.
+ *
+ * There is no reader fiber: the first waiting caller reads and dispatches
+ * for all of them, and hands the reading over to another waiter when its
+ * own response is in or its time is out.  Any read or write error breaks
+ * the connection and fails all the waiters, get() makes a new one then.
+ *
+ * The read and write timeouts are per call, the connect timeout is the
+ * one given when the connection was made.  The reading caller fails the
+ * others whose read timeout is out, waking at least every kLeadSlice to
+ * check, so a caller is late by kLeadSlice at most.
+ */
+class MuxConnection {
+ public:
+  // Id of a response body.
+  typedef std::function<int32_t(const std::string&)> IdFunc;
+
+  // Shared connection of peer, a broken one is replaced.  The connect
+  // timeout and idFunc are taken from the call making the connection.
+  static std::shared_ptr<MuxConnection> get(const Peer& peer,
+                                            const TimeoutOption& timeout,
+                                            IdFunc idFunc);
+
+  MuxConnection(const Peer& peer,
+                const TimeoutOption& timeout,
+                IdFunc idFunc);
+
+  int32_t nextId() { return ++id_; }
+
+  // Send request (frame body) tagged by id, wait for its response.
+  bool call(int32_t id,
+            const std::string& request,
+            std::string& response,
+            const TimeoutOption& timeout);
+
+  bool broken() const { return broken_; }
+
+  const Peer& peer() const { return peer_; }
+
+ private:
+  static constexpr uint64_t kLeadSlice = 10000;   // us
+  static constexpr uint32_t kMaxFrameSize = 1 << 24;
+
+  struct Waiter {
+    FiberBaton baton;
+    std::string response;
+    uint64_t deadline{0};  // of the read, 0 while writing
+    bool done{false};
+    bool ok{false};
+    bool notified{false};
+  };
+
+  bool connect();
+  bool write(const std::string& frame, uint64_t deadline);
+  // read and dispatch until self is done, false on timeout or error
+  bool lead(Waiter* self);
+  bool readFrames(Waiter* self);
+  // fail the waiters timed out by now, return the earliest deadline left
+  uint64_t expire(Waiter* self, uint64_t now);
+  void dispatch(std::string&& body, Waiter* self);
+  void handOver();
+  void fail(Waiter* self);
+  void notify(std::vector<Waiter*>& waiters);
+
+  Peer peer_;
+  TimeoutOption timeout_;
+  IdFunc idFunc_;
+  std::string label_;
+  std::atomic<int32_t> id_{0};
+
+  std::unique_ptr<Socket> socket_;
+  FiberMutex writeLock_;
+  std::string readBuf_;
+
+  std::mutex lock_;
+  std::unordered_map<int32_t, Waiter*> waiters_;
+  bool reading_{false};
+  std::atomic<bool> broken_{false};
+};
+
+} // namespace rdd
@@ -16,23 +16,105 @@
 
 #include "raster/net/NetHub.h"
 
+#include "accelerator/stats/Monitor.h"
+#include "raster/coroutine/FiberManager.h"
 #include "raster/net/Channel.h"
+#include "raster/net/CoProcessor.h"
+#include "raster/net/EventHandler.h"
 #include "raster/net/EventTask.h"
 
 namespace rdd {
 
 void NetHub::execute(Event* event) {
   if (event->task()) {
-    size_t i = event->group();
-    event->setGroup(0);
-    if (i == 0 || group_.finish(i)) {
-      FiberHub::execute(event->task()->fiber, event->channel()->id());
+    Fiber::Task* task = event->task();
+    bool grouped = event->grouped();
+    event->setGrouped(false);
+    // the task may be gone once another event takes the count to 0
+    if (!grouped ||
+        task->waitCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // resume on the pool of the task, not of the (client) channel
+      if (task->stackless) {
+        FiberHub::resume(task);
+      } else {
+        FiberHub::execute(task->fiber, task->poolId);
+      }
+    }
+    return;
+  }
+  if (Fiber::count() >= FLAGS_fc_limit &&
+      !event->channel()->processorFactory()->stackless()) {
+    ACCLOG(WARN) << *event << " exceed fiber capacity, reject";
+    ACCMON_CNT("service.reject-" + std::to_string(event->channel()->id()));
+    reject(event);
+    return;
+  }
+  auto admission = event->channel()->admission();
+  if (admission) {
+    switch (admission->admit(event)) {
+      case Admission::kQueued:
+        return;
+      case Admission::kReject:
+        ACCLOG(WARN) << *event << " exceed service capacity, reject";
+        reject(event);
+        return;
+      default:
+        break;
     }
   }
-  int poolId = event->channel()->id();
-  auto task = acc::make_unique<EventTask>(event);
-  task->scheduleCallback = [&]() { addEvent(event); };
-  FiberHub::execute(std::move(task), poolId);
+  dispatch(event, true);
+}
+
+void NetHub::dispatch(Event* event, bool allowIoRun) {
+  auto channel = event->channel();
+  auto& opt = channel->serviceOption();
+  bool ioRun = allowIoRun &&
+    opt.ioRun && !channel->processorFactory()->isHeavy(event);
+  auto admission = channel->admission();
+  std::unique_ptr<Fiber::Task> task;
+#if RDD_HAVE_COROUTINE
+  if (channel->processorFactory()->stackless()) {
+    task = acc::make_unique<CoEventTask>(event);
+  } else
+#endif
+  task = acc::make_unique<EventTask>(event);
+  // no use to process after the request's receive and send budget
+  auto timeout = channel->timeoutOption();
+  task->deadline = event->starttime() + timeout.rtimeout + timeout.wtimeout;
+  task->priority = opt.priority;
+  task->scheduleCallback = [this, event, admission]() {
+    addEvent(event);
+    if (admission) {
+      release(admission);
+    }
+  };
+  FiberHub::execute(std::move(task), channel->id(), opt.stackSize, ioRun);
+}
+
+void NetHub::watchQueue(Admission* admission) {
+  admission->setExpireCallback([this](Event* event) {
+    ACCLOG(WARN) << *event << " queue timeout, reject";
+    reject(event);
+  });
+}
+
+void NetHub::release(Admission* admission) {
+  std::vector<Event*> expired;
+  Event* next = admission->release(expired);
+  for (auto& event : expired) {
+    ACCLOG(WARN) << *event << " queue timeout, reject";
+    reject(event);
+  }
+  if (next) {
+    // from the pool thread, so never inline on it
+    dispatch(next, false);
+  }
+}
+
+void NetHub::reject(Event* event) {
+  event->processor()->reject();
+  event->setState(Event::kToWrite);
+  addEvent(event);
 }
 
 void NetHub::addEvent(Event* event) {
@@ -43,7 +125,8 @@ void NetHub::addEvent(Event* event) {
       }
     }
   }
-  getEventLoop()->addEvent(event);
+  auto loop = event->homeLoop();
+  (loop ? loop : getEventLoop())->addEvent(event);
 }
 
 void NetHub::forwardEvent(Event* event, const Peer& peer) {
@@ -60,19 +143,43 @@ void NetHub::forwardEvent(Event* event, const Peer& peer) {
 }
 
 bool NetHub::waitGroup(const std::vector<Event*>& events) {
+  if (events.empty()) {
+    return false;
+  }
   for (auto& event : events) {
-    if (event->group() != 0) {
+    if (event->grouped()) {
       ACCLOG(WARN) << "create group on grouping Event, giveup";
       return false;
     }
   }
-  size_t i = group_.create(events.size());
+  FiberManager::setWait(Fiber::kWaitGroup,
+                        std::to_string(events.size()).c_str());
+  // the events go to the loop after the yield, which publishes the count
+  getCurrentFiberTask()->waitCount.store(events.size(),
+                                         std::memory_order_relaxed);
   for (auto& event : events) {
-    event->setGroup(i);
+    event->setGrouped(true);
   }
   return true;
 }
 
+void NetHub::waitEvent(Fiber* fiber, Event* event) {
+  event->setTask(fiber->task());
+  event->setCompleteCallback([this](Event* ev) { execute(ev); });
+  event->setCloseCallback([this](Event* ev) { execute(ev); });
+  // an inline task is resumed on its loop only
+  auto loop = static_cast<acc::EventLoop*>(fiber->task()->ioHome);
+  // add after the fiber is switched out, it may be resumed at once
+  fiber->task()->blockCallbacks.push_back([this, event, loop]() {
+    auto l = loop ? loop : getEventLoop();
+    // a fd wait is armed to its deadline by the handler as it is added
+    if (!event->isFdWait() || !EventHandler::addWaitEvent(l, event)) {
+      l->addEvent(event);
+    }
+  });
+  FiberManager::yield();
+}
+
 void NetHub::setForwarding(bool forward) {
   forwarding_ = forward;
 }
@@ -18,8 +18,8 @@
 
 #include "accelerator/event/EventLoop.h"
 #include "raster/coroutine/FiberHub.h"
+#include "raster/net/Admission.h"
 #include "raster/net/Event.h"
-#include "raster/net/Group.h"
 #include "raster/net/NetUtil.h"
 
 namespace rdd {
@@ -33,19 +33,35 @@ struct ForwardTarget {
 class NetHub : public FiberHub {
  public:
   virtual acc::EventLoop* getEventLoop() = 0;
+  // all IO loops, for per-loop listeners
+  virtual std::vector<acc::EventLoop*> getEventLoops() = 0;
 
+  // New requests pass the fiber limit and the admission of their service
+  // first, rejected ones are replied by Processor::reject.
   void execute(Event* event);
 
+  // Reject the requests queued by admission on their queue timeout.
+  void watchQueue(Admission* admission);
+
   void addEvent(Event* event);
   void forwardEvent(Event* event, const Peer& peer);
 
+  // Park the current fiber until all the events, carrying its task,
+  // complete or close.  The count is kept on the task, lock free.
   bool waitGroup(const std::vector<Event*>& events);
 
+  // Park fiber (of this hub) until event, carrying its task, completes
+  // or closes on the event loop.
+  void waitEvent(Fiber* fiber, Event* event);
+
   void setForwarding(bool forward);
   void addForwardTarget(ForwardTarget&& t);
 
  private:
-  Group group_;
+  void dispatch(Event* event, bool allowIoRun);
+  void release(Admission* admission);
+  void reject(Event* event);
+
   bool forwarding_;
   std::vector<ForwardTarget> forwards_;
 };
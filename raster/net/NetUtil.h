@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include "accelerator/event/EventUtil.h"
@@ -25,9 +26,51 @@ namespace rdd {
 
 typedef acc::TimeoutOption TimeoutOption;
 
+// Managed keep-alive connections of a backend peer, times in us.
+struct PoolOption {
+  size_t minIdle{0};          // idle connections kept, made at warmup
+  size_t maxTotal{0};         // connections, 0 for no limit
+  uint64_t idleTimeout{0};    // max idle time, 0 for no limit
+  uint64_t maxLifetime{0};    // max time since connect, 0 for no limit
+  uint64_t probeInterval{0};  // liveness probe of idle ones, 0 for none
+
+  bool enabled() const {
+    return minIdle || maxTotal || idleTimeout || maxLifetime || probeInterval;
+  }
+};
+
+// Circuit breaker of a backend peer, times in us.
+struct BreakerOption {
+  double errorRate{0};        // of failed calls to open, 0 for none
+  double slowRate{0};         // of slow calls to open, 0 for none
+  uint64_t slowTime{0};       // a call longer is slow
+  size_t minCalls{20};        // in the window to judge the rates
+  uint64_t window{10000000};  // of the rates
+  uint64_t openTime{5000000}; // open before probing (half-open)
+  size_t probes{3};           // successful probes to close
+
+  bool enabled() const {
+    return errorRate > 0 || slowRate > 0;
+  }
+};
+
 struct ClientOption {
   Peer peer;
   TimeoutOption timeout;
+  PoolOption pool;            // keep-alive if enabled
+  BreakerOption breaker;      // fail fast if enabled
+};
+
+struct ServiceOption {
+  size_t stackSize{0};      // fiber stack size, 0 for FLAGS_fc_stack_size
+  bool ioRun{false};        // run handlers on the IO thread, except heavy ones
+  size_t maxConcurrency{0}; // running requests, 0 for no admission control
+  size_t maxQueue{0};       // waiting requests beyond maxConcurrency
+  uint64_t queueTimeout{0}; // max wait (us) in queue, 0 for no limit
+  int priority{0};          // of the fibers, higher runs first
+  int backlog{64};          // listen backlog
+  bool reusePort{false};    // a SO_REUSEPORT listener on each IO loop
+  uint64_t idleTimeout{0};  // max idle (us) of keep-alive, 0 for rtimeout
 };
 
 std::string getNodeName();
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "raster/net/NotifyTransport.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+namespace rdd {
+
+int NotifyTransport::readData(Socket* socket) {
+  state_ = kOnReading;
+  while (true) {
+    ssize_t r = ::read(socket->fd(), &count, sizeof(count));
+    if (r == sizeof(count)) {
+      state_ = kFinish;
+      return 1;
+    }
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EWOULDBLOCK || errno == EAGAIN) {
+        return -2;
+      }
+    }
+    state_ = kError;
+    return -1;
+  }
+}
+
+} // namespace rdd
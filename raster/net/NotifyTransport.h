@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "accelerator/Memory.h"
+#include "raster/net/Transport.h"
+
+namespace rdd {
+
+/*
+ * Transport of a notify fd (timerfd, eventfd), a read consumes the
+ * 8 bytes counter and completes.
+ */
+class NotifyTransport : public Transport {
+ public:
+  NotifyTransport() { reset(); }
+  ~NotifyTransport() override {}
+
+  void reset() override {
+    state_ = kInit;
+    count = 0;
+  }
+
+  void processReadData() override {}
+
+  int readData(Socket* socket) override;
+
+  uint64_t count;
+};
+
+class NotifyTransportFactory : public TransportFactory {
+ public:
+  NotifyTransportFactory() {}
+  ~NotifyTransportFactory() override {}
+
+  std::unique_ptr<Transport> create() override {
+    return acc::make_unique<NotifyTransport>();
+  }
+};
+
+/*
+ * Transport of a fd wait, a read completes at once without reading, as
+ * does a write with nothing to write.
+ */
+class WaitTransport : public Transport {
+ public:
+  WaitTransport() { reset(); }
+  ~WaitTransport() override {}
+
+  void reset() override {
+    state_ = kInit;
+  }
+
+  void processReadData() override {}
+
+  int readData(Socket* socket) override {
+    state_ = kFinish;
+    return 1;
+  }
+};
+
+class WaitTransportFactory : public TransportFactory {
+ public:
+  WaitTransportFactory() {}
+  ~WaitTransportFactory() override {}
+
+  std::unique_ptr<Transport> create() override {
+    return acc::make_unique<WaitTransport>();
+  }
+};
+
+} // namespace rdd
@@ -31,6 +31,9 @@ class Processor {
 
   virtual void run() = 0;
 
+  // Reply the request as rejected (overloaded) without running it.
+  virtual void reject() {}
+
  protected:
   Event* event_;
 };
@@ -39,6 +42,12 @@ class ProcessorFactory {
  public:
   virtual ~ProcessorFactory() {}
   virtual std::unique_ptr<Processor> create(Event* event) = 0;
+
+  // Heavy requests go to the CPU pool even if the service runs on IO.
+  virtual bool isHeavy(Event*) { return false; }
+
+  // Processors are CoProcessor, run as stackless coroutines.
+  virtual bool stackless() const { return false; }
 };
 
 } // namespace rdd
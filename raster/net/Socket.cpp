@@ -19,7 +19,9 @@
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <linux/errqueue.h>
 #include <netdb.h>
+#include <netinet/in.h>
 #include <netinet/tcp.h>
 
 #include "accelerator/Conv.h"
@@ -72,9 +74,8 @@ Socket::Socket() {
   ++count_;
 }
 
-Socket::Socket(int fd, const Peer& peer)
-  : fd_(fd), peer_(peer) {
-  role_ = kServer;
+Socket::Socket(int fd, const Peer& peer, Role role)
+  : fd_(fd), peer_(peer), role_(role) {
   ++count_;
 }
 
@@ -108,9 +109,12 @@ bool Socket::listen(int backlog) {
 std::unique_ptr<Socket> Socket::accept() {
   struct sockaddr_in sin;
   socklen_t len = sizeof(sin);
-  int fd = ::accept(fd_, (struct sockaddr*)&sin, &len);
+  int fd = ::accept4(fd_, (struct sockaddr*)&sin, &len,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
   if (fd == -1) {
-    ACCPLOG(ERROR) << "fd(" << fd_ << "): accept error";
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      ACCPLOG(ERROR) << "fd(" << fd_ << "): accept error";
+    }
     return nullptr;
   }
   Peer peer;
@@ -152,11 +156,29 @@ void Socket::close() {
   --count_;
 }
 
+int Socket::release() {
+  int fd = fd_;
+  if (fd_ != -1) {
+    fd_ = -1;
+    --count_;
+  }
+  return fd;
+}
+
 bool Socket::isClosed() {
   char p[8];
   return recv(p, sizeof(p)) == 0;
 }
 
+bool Socket::isIdle() {
+  if (!isConnected()) {
+    return false;
+  }
+  char p;
+  ssize_t r = ::recv(fd_, &p, sizeof(p), MSG_PEEK | MSG_DONTWAIT);
+  return r == -1 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
+
 ssize_t Socket::recv(void* buf, size_t n) {
   while (true) {
     ssize_t r = ::recv(fd_, buf, n, 0);
@@ -175,6 +197,27 @@ ssize_t Socket::recv(void* buf, size_t n) {
   }
 }
 
+ssize_t Socket::recvv(struct iovec* iov, int iovcnt) {
+  struct msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+  while (true) {
+    ssize_t r = ::recvmsg(fd_, &msg, 0);
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EWOULDBLOCK || errno == EAGAIN) {
+        return -2;
+      }
+      if (errno == ECONNRESET) {
+        return -3;
+      }
+    }
+    return r;
+  }
+}
+
 ssize_t Socket::send(const void* buf, size_t n) {
   // Note the use of MSG_NOSIGNAL to suppress SIGPIPE errors, instead we
   // check for the EPIPE return condition and close the socket in that case
@@ -192,6 +235,58 @@ ssize_t Socket::send(const void* buf, size_t n) {
   }
 }
 
+ssize_t Socket::sendv(const struct iovec* iov, int iovcnt, int flags) {
+  struct msghdr msg = {};
+  msg.msg_iov = const_cast<struct iovec*>(iov);
+  msg.msg_iovlen = iovcnt;
+  while (true) {
+    ssize_t r = ::sendmsg(fd_, &msg, MSG_NOSIGNAL | flags);
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EWOULDBLOCK || errno == EAGAIN) {
+        return -2;
+      }
+    }
+    return r;
+  }
+}
+
+int Socket::recvZeroCopy(uint32_t& hi) {
+  int n = 0;
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+  while (true) {
+    char control[128];
+    struct msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t r = ::recvmsg(fd_, &msg, MSG_ERRQUEUE);
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;  // EAGAIN: drained
+    }
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+         cm != nullptr;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+      auto err = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+      if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      hi = err->ee_data;
+      ++n;
+    }
+  }
+#endif
+  return n;
+}
+
 bool Socket::setRecvTimeout(uint64_t t) {
   struct timeval tv = acc::toTimeval(t);
   socklen_t len = sizeof(tv);
@@ -265,6 +360,16 @@ bool Socket::setReuseAddr() {
   return r != -1;
 }
 
+bool Socket::setReusePort() {
+  int reuse = 1;
+  socklen_t len = sizeof(reuse);
+  int r = setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &reuse, len);
+  if (r == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd_ << "): set SO_REUSEPORT failed";
+  }
+  return r != -1;
+}
+
 bool Socket::setTCPNoDelay() {
   int nodelay = 1;
   socklen_t len = sizeof(nodelay);
@@ -275,6 +380,29 @@ bool Socket::setTCPNoDelay() {
   return r != -1;
 }
 
+bool Socket::setZeroCopy() {
+#ifdef SO_ZEROCOPY
+  int zerocopy = 1;
+  socklen_t len = sizeof(zerocopy);
+  int r = setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &zerocopy, len);
+  if (r == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd_ << "): set SO_ZEROCOPY failed";
+  }
+  zeroCopy_ = r != -1;
+#endif
+  return zeroCopy_;
+}
+
+bool Socket::setUserTimeout(uint64_t t) {
+  unsigned int ms = t / 1000;
+  socklen_t len = sizeof(ms);
+  int r = setsockopt(fd_, IPPROTO_TCP, TCP_USER_TIMEOUT, &ms, len);
+  if (r == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd_ << "): set TCP_USER_TIMEOUT failed";
+  }
+  return r != -1;
+}
+
 bool Socket::getError(int& err) {
   socklen_t len = sizeof(err);
   int r = getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len);
@@ -284,6 +412,18 @@ bool Socket::getError(int& err) {
   return r != -1;
 }
 
+bool Socket::isSendDone() {
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+  if (getsockopt(fd_, IPPROTO_TCP, TCP_INFO, &info, &len) == -1) {
+    ACCPLOG(ERROR) << "fd(" << fd_ << "): get TCP_INFO failed";
+    return true;
+  }
+  return info.tcpi_state == TCP_FIN_WAIT2 ||
+         info.tcpi_state == TCP_TIME_WAIT ||
+         info.tcpi_state == TCP_CLOSE;
+}
+
 const char* Socket::roleName() const {
   return roleStrings[role_];
 }
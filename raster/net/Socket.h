@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unistd.h>
+#include <sys/uio.h>
 
 #include "raster/Portability.h"
 #include "raster/net/NetUtil.h"
@@ -49,7 +50,7 @@ class Socket {
   static std::unique_ptr<Socket> createAsyncSocket();
 
   Socket();
-  Socket(int fd, const Peer& peer);
+  Socket(int fd, const Peer& peer, Role role = kServer);
 
   ~Socket();
 
@@ -59,6 +60,8 @@ class Socket {
 
   bool bind(int port);
   bool listen(int backlog);
+  // Return nullptr if no pending connection or on error, the accepted
+  // socket is non-blocking.
   std::unique_ptr<Socket> accept();
 
   bool connect(const Peer& peer);
@@ -66,6 +69,11 @@ class Socket {
 
   void close();
   bool isClosed();
+  // Connected, and no EOF or stray data to read.  Reads nothing.
+  bool isIdle();
+
+  // Give up the fd without closing it.
+  int release();
 
   /*
    * return:
@@ -76,7 +84,15 @@ class Socket {
    *  -3: peer is closed
    */
   ssize_t recv(void* buf, size_t n);
+  // scatter recv, return as recv()
+  ssize_t recvv(struct iovec* iov, int iovcnt);
   ssize_t send(const void* buf, size_t n);
+  // gather send, flags are added to MSG_NOSIGNAL
+  ssize_t sendv(const struct iovec* iov, int iovcnt, int flags = 0);
+
+  // Reap MSG_ZEROCOPY notifications from the error queue, hi is set to
+  // the id of the last completed send.  Return # of notifications.
+  int recvZeroCopy(uint32_t& hi);
 
   bool setRecvTimeout(uint64_t t);
   bool setSendTimeout(uint64_t t);
@@ -89,9 +105,15 @@ class Socket {
   bool setLinger(int timeout);
   bool setNonBlocking();
   bool setReuseAddr();
+  bool setReusePort();
   bool setTCPNoDelay();
+  bool setZeroCopy();  // SO_ZEROCOPY, for sends with MSG_ZEROCOPY
+  bool setUserTimeout(uint64_t t);  // TCP_USER_TIMEOUT
 
   bool getError(int& err);
+  // Whether the data sent is all acked or dropped (FIN_WAIT2, TIME_WAIT,
+  // CLOSE), so no send completes any more.
+  bool isSendDone();
 
   int fd() const { return fd_; }
   const Peer& peer() const { return peer_; }
@@ -102,12 +124,15 @@ class Socket {
   bool isClient() const { return role_ == Role::kClient; }
   bool isServer() const { return role_ == Role::kServer; }
 
+  bool isZeroCopy() const { return zeroCopy_; }
+
  private:
   static std::atomic<size_t> count_;
 
   int fd_{-1};
   Peer peer_;
   Role role_{kNone};
+  bool zeroCopy_{false};
 };
 
 std::ostream& operator<<(std::ostream& os, const Socket& socket);
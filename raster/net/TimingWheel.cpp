@@ -0,0 +1,182 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster/net/TimingWheel.h"
+
+#include <algorithm>
+
+#include "accelerator/Time.h"
+
+DEFINE_uint64(net_timer_tick, 10000,
+              "Tick (us) of the timing wheels of net timeouts.");
+
+namespace rdd {
+
+constexpr size_t TimingWheel::kLevels;
+constexpr size_t TimingWheel::kBits;
+constexpr size_t TimingWheel::kSlots;
+
+TimingWheel::TimingWheel(uint64_t tick)
+  : tick_(std::max(tick, uint64_t(1))),
+    current_(acc::timestampNow() / tick_) {
+  for (auto& level : slots_) {
+    for (auto& head : level) {
+      head.prev = head.next = &head;
+    }
+  }
+}
+
+void TimingWheel::schedule(Timer* timer, uint64_t timeout) {
+  cancel(timer);
+  // round up, never fire early
+  uint64_t expire = (acc::timestampNow() + timeout + tick_ - 1) / tick_;
+  timer->expire = std::max(expire, current_ + 1);
+  insert(timer);
+  ++size_;
+}
+
+void TimingWheel::cancel(Timer* timer) {
+  if (timer->scheduled()) {
+    unlink(timer);
+    --size_;
+  }
+}
+
+size_t TimingWheel::advance(uint64_t now) {
+  size_t n = 0;
+  Timer* timer;
+  // unlinked before the callback, it may reschedule or free the timer
+  while ((timer = expire(now)) != nullptr) {
+    ++n;
+    timer->callback();
+  }
+  return n;
+}
+
+TimingWheel::Timer* TimingWheel::expire(uint64_t now) {
+  uint64_t target = now / tick_;
+  while (true) {
+    Node* head = &slots_[0][current_ & (kSlots - 1)];
+    if (head->next != head) {
+      Timer* timer = static_cast<Timer*>(head->next);
+      unlink(timer);
+      --size_;
+      return timer;
+    }
+    if (current_ >= target) {
+      return nullptr;
+    }
+    ++current_;
+    // cascade the next slot of the upper levels on wrap
+    for (size_t level = 1; level < kLevels; ++level) {
+      if ((current_ & ((uint64_t(1) << (kBits * level)) - 1)) != 0) {
+        break;
+      }
+      cascade(level);
+    }
+  }
+}
+
+void TimingWheel::insert(Timer* timer) {
+  uint64_t delta = timer->expire - current_;
+  size_t level = 0;
+  while (level < kLevels - 1 &&
+         delta >= (uint64_t(1) << (kBits * (level + 1)))) {
+    ++level;
+  }
+  if (delta >= (uint64_t(1) << (kBits * kLevels))) {
+    // beyond the wheel, clamp to its far end
+    timer->expire = current_ + (uint64_t(1) << (kBits * kLevels)) - 1;
+  }
+  size_t slot = (timer->expire >> (kBits * level)) & (kSlots - 1);
+  link(&slots_[level][slot], timer);
+}
+
+void TimingWheel::cascade(size_t level) {
+  Node* head = &slots_[level][(current_ >> (kBits * level)) & (kSlots - 1)];
+  Node list;
+  list.prev = list.next = &list;
+  if (head->next != head) {
+    list.next = head->next;
+    list.prev = head->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    head->prev = head->next = head;
+  }
+  while (list.next != &list) {
+    Timer* timer = static_cast<Timer*>(list.next);
+    unlink(timer);
+    insert(timer);
+  }
+}
+
+void TimingWheel::link(Node* head, Node* node) {
+  node->prev = head->prev;
+  node->next = head;
+  head->prev->next = node;
+  head->prev = node;
+}
+
+void TimingWheel::unlink(Node* node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->prev = node->next = nullptr;
+}
+
+void SharedTimingWheel::schedule(TimingWheel::Timer* timer,
+                                 uint64_t timeout) {
+  std::lock_guard<std::mutex> guard(lock_);
+  wheel_.schedule(timer, timeout);
+}
+
+bool SharedTimingWheel::cancel(TimingWheel::Timer* timer) {
+  std::unique_lock<std::mutex> guard(lock_);
+  fired_.wait(guard, [&]() {
+    return firing_ != timer ||
+      firingThread_ == std::this_thread::get_id();
+  });
+  bool scheduled = timer->scheduled();
+  wheel_.cancel(timer);
+  return scheduled;
+}
+
+void SharedTimingWheel::advance(uint64_t now) {
+  std::unique_lock<std::mutex> guard(lock_);
+  if (advancing_) {
+    return;
+  }
+  advancing_ = true;
+  firingThread_ = std::this_thread::get_id();
+  TimingWheel::Timer* timer;
+  while ((timer = wheel_.expire(now)) != nullptr) {
+    // the timer may be freed by its own callback
+    auto callback = timer->callback;
+    firing_ = timer;
+    guard.unlock();
+    callback();
+    guard.lock();
+    firing_ = nullptr;
+    fired_.notify_all();
+  }
+  advancing_ = false;
+}
+
+size_t SharedTimingWheel::size() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return wheel_.size();
+}
+
+} // namespace rdd
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "raster/Portability.h"
+
+DECLARE_uint64(net_timer_tick);
+
+namespace rdd {
+
+/*
+ * Hierarchical timing wheel, 4 levels of 256 slots, so schedule and
+ * cancel are O(1) and a tick only touches the due slot (far timers are
+ * cascaded down once per level).  Timers are intrusive and owned by the
+ * caller, a timer must be cancelled before it is destroyed.
+ *
+ * Not thread safe, it belongs to one event loop.  Times are in us.
+ */
+class TimingWheel {
+ public:
+  struct Node {
+    Node* prev{nullptr};
+    Node* next{nullptr};
+  };
+
+  struct Timer : Node {
+    std::function<void()> callback;
+
+    bool scheduled() const { return next != nullptr; }
+
+    uint64_t expire{0};  // in ticks
+  };
+
+  explicit TimingWheel(uint64_t tick);
+
+  uint64_t tick() const { return tick_; }
+
+  // (Re)schedule timer to fire after timeout.
+  void schedule(Timer* timer, uint64_t timeout);
+  void cancel(Timer* timer);
+
+  // Fire the timers expired by now, return # of fired.
+  size_t advance(uint64_t now);
+
+  // Unlink a timer expired by now without firing it, nullptr if none.
+  Timer* expire(uint64_t now);
+
+  size_t size() const { return size_; }
+
+ private:
+  static constexpr size_t kLevels = 4;
+  static constexpr size_t kBits = 8;
+  static constexpr size_t kSlots = 1 << kBits;
+
+  void insert(Timer* timer);
+  void cascade(size_t level);
+
+  static void link(Node* head, Node* node);
+  static void unlink(Node* node);
+
+  uint64_t tick_;
+  uint64_t current_;  // in ticks
+  size_t size_{0};
+  Node slots_[kLevels][kSlots];  // list heads
+};
+
+/*
+ * TimingWheel of FLAGS_net_timer_tick shared by all threads, for timers
+ * armed off the event loops (fiber sleeps, queue deadlines).  It is
+ * advanced by the tickers of the loops' EventHandlers, by whichever
+ * comes first.
+ *
+ * Callbacks run out of its lock, on a copy: a callback may schedule,
+ * cancel or free its timer.  Once cancel() returns (not called from the
+ * callback), the callback is not running.
+ */
+class SharedTimingWheel {
+ public:
+  SharedTimingWheel() : wheel_(FLAGS_net_timer_tick) {}
+
+  uint64_t tick() const { return wheel_.tick(); }
+
+  // Whether a ticker advances the wheel, its timers never fire if not.
+  bool driven() const { return drivers_ > 0; }
+  void addDriver() { ++drivers_; }
+  void removeDriver() { --drivers_; }
+
+  void schedule(TimingWheel::Timer* timer, uint64_t timeout);
+  // Return false if timer was not scheduled (fired or never armed).
+  bool cancel(TimingWheel::Timer* timer);
+
+  // Skipped if another thread is advancing.
+  void advance(uint64_t now);
+
+  size_t size() const;
+
+ private:
+  mutable std::mutex lock_;
+  std::condition_variable fired_;
+  TimingWheel wheel_;
+  bool advancing_{false};
+  TimingWheel::Timer* firing_{nullptr};
+  std::thread::id firingThread_;
+  std::atomic<size_t> drivers_{0};
+};
+
+} // namespace rdd
@@ -16,11 +16,43 @@
 
 #include "raster/net/Transport.h"
 
+#include <algorithm>
+#include <sys/socket.h>
+
+#include "accelerator/Logging.h"
+#include "accelerator/Time.h"
+#include "accelerator/stats/Monitor.h"
+
+DEFINE_uint64(net_zerocopy_threshold, 0,
+              "Send replies of at least this size with MSG_ZEROCOPY, "
+              "0 to disable.");
+
 namespace rdd {
 
+const uint32_t Transport::kMinReadSize;
+const uint32_t Transport::kMaxReadSize;
+const uint32_t Transport::kMaxHintSize;
+const int Transport::kMaxIov;
+
+namespace {
+
+// overflow of a read of unknown size, copied into readBuf_
+const size_t kSpillSize = 65536;
+__thread uint8_t spill[kSpillSize];
+
+}
+
 void Transport::getReadBuffer(void** buf, size_t* bufSize) {
+  // the rest of a known frame goes to one buffer of its size, grown as
+  // its bytes arrive: the size is the peer's word, not to pin memory of
+  // an idle connection on
+  uint32_t size = readHint_ > 0
+    ? std::min({readHint_,
+                size_t(kMaxHintSize),
+                std::max(2 * readBytes_, size_t(kMaxReadSize))})
+    : readSize_;
   std::pair<void*, uint32_t> readSpace =
-    readBuf_.preallocate(kMinReadSize, kMaxReadSize);
+    readBuf_.preallocate(readHint_ > 0 ? size : kMinReadSize, size);
   *buf = readSpace.first;
   *bufSize = readSpace.second;
 }
@@ -32,38 +64,181 @@ void Transport::readDataAvailable(size_t readSize) {
 }
 
 int Transport::readData(Socket* socket) {
+  // the error queue wakes the loop up as readable, drain it here
+  reapZeroCopy(socket);
   state_ = kOnReading;
+  // a pipelined request may be buffered already
+  if (readBuf_.chainLength() != 0) {
+    readBytes_ += readBuf_.chainLength();
+    processReadData();
+    if (state_ == kError) {
+      return -1;
+    }
+  }
   while (state_ != kFinish) {
     void* buf;
     size_t bufSize;
     getReadBuffer(&buf, &bufSize);
-    ssize_t r = socket->recv(buf, bufSize);
+    struct iovec iov[2] = {{buf, bufSize}, {spill, kSpillSize}};
+    // spill only when the frame size is unknown
+    ssize_t r = socket->recvv(iov, readHint_ > 0 ? 1 : 2);
+    ++recvCalls_;
     if (r <= 0) {
       return r;
     }
-    readDataAvailable(r);
+    readBytes_ += r;
+    if (readHint_ == 0) {
+      adjustReadSize(r, bufSize);
+    }
+    if (size_t(r) > bufSize) {
+      ACCLOG(V3) << "read completed, bytes=" << r;
+      readBuf_.postallocate(bufSize);
+      readBuf_.append(spill, r - bufSize);
+      processReadData();
+    } else {
+      readDataAvailable(r);
+    }
     if (state_ == kError) {
       return -1;
     }
   }
+  ACCMON_AVG("net.recv_calls", recvCalls_);
+  recvCalls_ = 0;
+  readBytes_ = 0;
+  readHint_ = 0;
   return 1;
 }
 
+void Transport::adjustReadSize(size_t readSize, size_t bufSize) {
+  if (readSize >= bufSize) {
+    readSize_ = std::min(readSize_ * 2, kMaxReadSize);
+  } else if (readSize < bufSize / 4) {
+    readSize_ = std::max(readSize_ / 2, kMinReadSize);
+  }
+}
+
 int Transport::writeData(Socket* socket) {
   if (state_ == kError) {
     return -1;
   }
-  const acc::IOBuf* buf;
-  while ((buf = writeBuf_.front()) != nullptr && buf->length() != 0) {
-    ssize_t r = socket->send(buf->data(), buf->length());
+  reapZeroCopy(socket);
+  int flags = 0;
+  if (FLAGS_net_zerocopy_threshold > 0 &&
+      writeBuf_.chainLength() >= FLAGS_net_zerocopy_threshold) {
+    if (!zeroCopyTried_) {
+      zeroCopyTried_ = true;
+      socket->setZeroCopy();
+    }
+#ifdef MSG_ZEROCOPY
+    if (socket->isZeroCopy()) {
+      flags = MSG_ZEROCOPY;
+    }
+#endif
+  }
+  struct iovec iov[kMaxIov];
+  while (writeBuf_.chainLength() != 0) {
+    const acc::IOBuf* head = writeBuf_.front();
+    const acc::IOBuf* buf = head;
+    int n = 0;
+    do {
+      if (buf->length() != 0) {
+        iov[n].iov_base = const_cast<uint8_t*>(buf->data());
+        iov[n].iov_len = buf->length();
+        ++n;
+      }
+      buf = buf->next();
+    } while (buf != head && n < kMaxIov);
+    ssize_t r = socket->sendv(iov, n, flags);
+    if (r < 0 && flags && errno == ENOBUFS) {
+      // out of optmem for pinned pages, copy this time
+      ACCMON_CNT("net.zerocopy_nobufs");
+      r = socket->sendv(iov, n);
+      if (r > 0) {
+        writeBuf_.trimStart(r);
+        continue;
+      }
+    }
     if (r < 0) {
       return r;
     }
-    writeBuf_.trimStart(r);
+    if (r == 0) {
+      return -2;  // nothing taken, no empty split to hold
+    }
+    if (flags) {
+      // the kernel reads the pages until the send completes
+      zeroCopyBufs_.emplace_back(zeroCopyId_++, writeBuf_.split(r));
+    } else {
+      writeBuf_.trimStart(r);
+    }
   }
   return 1;
 }
 
+void Transport::reapZeroCopy(Socket* socket) {
+  if (zeroCopyBufs_.empty()) {
+    return;
+  }
+  uint32_t hi;
+  if (socket->recvZeroCopy(hi) == 0) {
+    return;
+  }
+  // ids complete in order, compare with wraparound
+  while (!zeroCopyBufs_.empty() &&
+         int32_t(zeroCopyBufs_.front().first - hi) <= 0) {
+    zeroCopyBufs_.pop_front();
+  }
+}
+
+constexpr uint64_t ZeroCopyReaper::kMaxHold;
+
+void ZeroCopyReaper::adopt(std::unique_ptr<Socket> socket,
+                           std::unique_ptr<Transport> transport) {
+  transport->reapZeroCopy(socket.get());
+  if (!transport->zeroCopyPending()) {
+    return;
+  }
+  // end the connection now, the fd stays for the notifications; a peer
+  // not acking the data is aborted, which completes the sends too
+  socket->setUserTimeout(kMaxHold);
+  ::shutdown(socket->fd(), SHUT_RDWR);
+  ACCMON_CNT("net.zerocopy_held");
+  std::lock_guard<std::mutex> guard(lock_);
+  held_.push_back({std::move(socket), std::move(transport),
+                   acc::timestampNow()});
+  size_.store(held_.size(), std::memory_order_relaxed);
+}
+
+void ZeroCopyReaper::reap(uint64_t now) {
+  if (size() == 0) {
+    return;
+  }
+  std::vector<Held> done;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (size_t i = 0; i < held_.size(); ) {
+      Held& h = held_[i];
+      h.transport->reapZeroCopy(h.socket.get());
+      // freed on completion; only a connection done with its data may
+      // still miss notifications, given up after kMaxHold
+      if (h.transport->zeroCopyPending() &&
+          (now < h.time + kMaxHold || !h.socket->isSendDone())) {
+        ++i;
+        continue;
+      }
+      done.push_back(std::move(h));
+      std::swap(h, held_.back());
+      held_.pop_back();
+    }
+    size_.store(held_.size(), std::memory_order_relaxed);
+  }
+  for (auto& h : done) {
+    if (h.transport->zeroCopyPending()) {
+      ACCLOG(WARN) << "fd(" << h.socket->fd() << "): zerocopy sends not "
+        << "completed in " << kMaxHold << "us after close, free them";
+    }
+  }
+}
+
 void Transport::clone(Transport* other) {
   state_ = other->state_;
   readBuf_.append(other->readBuf_.front()->clone());
@@ -16,9 +16,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 #include "accelerator/io/IOBufQueue.h"
+#include "raster/Portability.h"
 #include "raster/net/Socket.h"
 
+DECLARE_uint64(net_zerocopy_threshold);
+
 namespace rdd {
 
 class Transport {
@@ -30,8 +38,13 @@ class Transport {
     kError,
   };
 
+  // bounds of the adaptive read size, grown on full reads and shrunk on
+  // short ones
   static const uint32_t kMinReadSize = 1460;
-  static const uint32_t kMaxReadSize = 4000;
+  static const uint32_t kMaxReadSize = 65536;
+  // largest buffer allocated for the rest of a known frame, at most
+  // twice the bytes read of it (or kMaxReadSize) at a time
+  static const uint32_t kMaxHintSize = 1 << 24;
 
   virtual ~Transport() {}
 
@@ -48,9 +61,18 @@ class Transport {
   void getReadBuffer(void** buf, size_t* bufSize);
   void readDataAvailable(size_t readSize);
 
-  int readData(Socket* socket);
+  virtual int readData(Socket* socket);
+  // bytes read of the current frame, 0 before its first byte
+  size_t readBytes() const { return readBytes_; }
+  // Flush writeBuf_ by gather sends, with MSG_ZEROCOPY if it is as large
+  // as FLAGS_net_zerocopy_threshold.
   int writeData(Socket* socket);
 
+  // MSG_ZEROCOPY sends not completed, their buffers outlive the event
+  // (see ZeroCopyReaper)
+  bool zeroCopyPending() const { return !zeroCopyBufs_.empty(); }
+  void reapZeroCopy(Socket* socket);
+
   void clone(Transport* other);
 
  protected:
@@ -59,6 +81,53 @@ class Transport {
   IngressState state_;
   acc::IOBufQueue readBuf_{acc::IOBufQueue::cacheChainLength()};
   acc::IOBufQueue writeBuf_{acc::IOBufQueue::cacheChainLength()};
+  // bytes the current frame still needs, 0 if unknown
+  size_t readHint_{0};
+
+ private:
+  static const int kMaxIov = 64;
+
+  void adjustReadSize(size_t readSize, size_t bufSize);
+
+  uint32_t readSize_{kMinReadSize};
+  uint32_t recvCalls_{0};
+  size_t readBytes_{0};
+
+  // sent with MSG_ZEROCOPY, held until the kernel completes its send id
+  std::deque<std::pair<uint32_t, std::unique_ptr<acc::IOBuf>>> zeroCopyBufs_;
+  uint32_t zeroCopyId_{0};
+  bool zeroCopyTried_{false};
+};
+
+/*
+ * Holds the socket and transport of a freed event until its MSG_ZEROCOPY
+ * sends complete, as the kernel reads their pages till then.  The socket
+ * is shut down at once (aborted if the peer acks nothing for kMaxHold),
+ * and closed when the notifications arrive.  Only when the connection is
+ * done with its data but notifications are missing, it is given up after
+ * kMaxHold.  Reaped on the ticks of the loops, thread safe.
+ */
+class ZeroCopyReaper {
+ public:
+  void adopt(std::unique_ptr<Socket> socket,
+             std::unique_ptr<Transport> transport);
+
+  void reap(uint64_t now);
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr uint64_t kMaxHold = 60000000; // us
+
+  struct Held {
+    std::unique_ptr<Socket> socket;
+    std::unique_ptr<Transport> transport;
+    uint64_t time;
+  };
+
+  std::mutex lock_;
+  std::vector<Held> held_;
+  std::atomic<size_t> size_{0};
 };
 
 class TransportFactory {
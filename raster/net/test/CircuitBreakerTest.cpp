@@ -0,0 +1,165 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "raster/net/CircuitBreaker.h"
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+using namespace rdd;
+
+namespace {
+
+// openTime, and a sleep past it, with wide margins against a loaded box
+const uint64_t kOpenTime = 200000;
+const uint64_t kPastOpen = 500000;
+
+BreakerOption makeOption() {
+  BreakerOption option;
+  option.errorRate = 0.5;
+  option.minCalls = 10;
+  option.openTime = kOpenTime;
+  option.probes = 2;
+  return option;
+}
+
+void call(CircuitBreaker& breaker, bool ok, uint64_t latency = 0) {
+  auto ticket = breaker.allow();
+  EXPECT_TRUE(bool(ticket));
+  breaker.record(ticket, ok, latency);
+}
+
+void open(CircuitBreaker& breaker) {
+  for (int i = 0; i < 10; ++i) {
+    call(breaker, false);
+  }
+  EXPECT_EQ(CircuitBreaker::kOpen, breaker.state());
+}
+
+}
+
+TEST(CircuitBreaker, openOnErrorRate) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  for (int i = 0; i < 9; ++i) {
+    call(breaker, false);
+  }
+  // not judged under minCalls
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+  call(breaker, false);
+  EXPECT_EQ(CircuitBreaker::kOpen, breaker.state());
+  EXPECT_FALSE(bool(breaker.allow()));
+}
+
+TEST(CircuitBreaker, stayClosedUnderErrorRate) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  for (int i = 0; i < 30; ++i) {
+    call(breaker, i % 3 != 0);
+  }
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+}
+
+TEST(CircuitBreaker, openOnSlowRate) {
+  BreakerOption option = makeOption();
+  option.errorRate = 0;
+  option.slowRate = 0.5;
+  option.slowTime = 1000;
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), option);
+  for (int i = 0; i < 9; ++i) {
+    call(breaker, true, 5000);
+  }
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+  call(breaker, true, 5000);
+  EXPECT_EQ(CircuitBreaker::kOpen, breaker.state());
+}
+
+TEST(CircuitBreaker, closeOnProbes) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  open(breaker);
+  usleep(kPastOpen);
+  // half-open, as many probes as option.probes
+  auto a = breaker.allow();
+  EXPECT_TRUE(bool(a));
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+  auto b = breaker.allow();
+  EXPECT_TRUE(bool(b));
+  EXPECT_FALSE(bool(breaker.allow()));
+  breaker.record(a, true, 0);
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+  EXPECT_FALSE(bool(breaker.allow()));
+  breaker.record(b, true, 0);
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+  // the window starts over
+  for (int i = 0; i < 9; ++i) {
+    call(breaker, false);
+  }
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+}
+
+TEST(CircuitBreaker, reopenOnFailedProbe) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  open(breaker);
+  usleep(kPastOpen);
+  call(breaker, true);
+  call(breaker, false);
+  EXPECT_EQ(CircuitBreaker::kOpen, breaker.state());
+  EXPECT_FALSE(bool(breaker.allow()));
+  // a late result while open changes nothing
+  breaker.record(CircuitBreaker::Ticket(), true, 0);
+  EXPECT_EQ(CircuitBreaker::kOpen, breaker.state());
+}
+
+TEST(CircuitBreaker, ignoreCallsBeforeOpen) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  auto late = breaker.allow();
+  EXPECT_TRUE(bool(late));
+  open(breaker);
+  usleep(kPastOpen);
+  auto probe = breaker.allow();
+  EXPECT_TRUE(bool(probe));
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+  // taken while closed, not a probe
+  breaker.record(late, false, 0);
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+  breaker.record(probe, true, 0);
+  call(breaker, true);
+  EXPECT_EQ(CircuitBreaker::kClosed, breaker.state());
+}
+
+TEST(CircuitBreaker, giveUpLostProbes) {
+  CircuitBreaker breaker(Peer("127.0.0.1", 8000), makeOption());
+  open(breaker);
+  usleep(kPastOpen);
+  auto lost = breaker.allow();
+  EXPECT_TRUE(bool(lost));
+  EXPECT_TRUE(bool(breaker.allow()));
+  EXPECT_FALSE(bool(breaker.allow()));
+  // never recorded
+  usleep(kPastOpen);
+  EXPECT_TRUE(bool(breaker.allow()));
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+  // a probe of the round given up counts no more
+  breaker.record(lost, false, 0);
+  EXPECT_EQ(CircuitBreaker::kHalfOpen, breaker.state());
+}
+
+TEST(CircuitBreakerManager, breakerPerPeer) {
+  CircuitBreakerManager manager;
+  BreakerOption option = makeOption();
+  auto a = manager.getBreaker(Peer("127.0.0.1", 8000), option);
+  auto b = manager.getBreaker(Peer("127.0.0.1", 8001), option);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, manager.getBreaker(Peer("127.0.0.1", 8000), option));
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "raster/net/Hedge.h"
+#include <gtest/gtest.h>
+
+using namespace rdd;
+
+TEST(HedgePolicy, fixedDelay) {
+  HedgeOption option;
+  option.delay = 5000;
+  HedgePolicy policy("fixed", option);
+  EXPECT_EQ(5000, policy.delay());
+  for (int i = 0; i < 1000; ++i) {
+    policy.addLatency(100000);
+  }
+  EXPECT_EQ(5000, policy.delay());
+}
+
+TEST(HedgePolicy, percentileDelay) {
+  HedgeOption option;
+  option.percentile = 95;
+  HedgePolicy policy("p95", option);
+  // no hedge before enough samples
+  EXPECT_EQ(0, policy.delay());
+  for (int i = 1; i < 64; ++i) {
+    policy.addLatency(i * 1000);
+  }
+  EXPECT_EQ(0, policy.delay());
+  policy.addLatency(64 * 1000);
+  EXPECT_EQ(61000, policy.delay());
+}
+
+TEST(HedgePolicy, minDelay) {
+  HedgeOption option;
+  option.minDelay = 2000;
+  HedgePolicy policy("min", option);
+  for (int i = 0; i < 64; ++i) {
+    policy.addLatency(10);
+  }
+  EXPECT_EQ(2000, policy.delay());
+}
+
+TEST(HedgePolicy, recentSamples) {
+  HedgePolicy policy("recent", HedgeOption());
+  for (int i = 0; i < 1024; ++i) {
+    policy.addLatency(100000);
+  }
+  EXPECT_EQ(100000, policy.delay());
+  // the old samples are replaced
+  for (int i = 0; i < 1024; ++i) {
+    policy.addLatency(3000);
+  }
+  EXPECT_EQ(3000, policy.delay());
+}
+
+TEST(HedgePolicy, budget) {
+  HedgeOption option;
+  option.budget = 0.25;
+  HedgePolicy policy("budget", option);
+  EXPECT_FALSE(policy.tryHedge());
+  for (int i = 0; i < 4; ++i) {
+    policy.addRequest();
+  }
+  EXPECT_TRUE(policy.tryHedge());
+  EXPECT_FALSE(policy.tryHedge());
+  // the budget saved up is capped
+  for (int i = 0; i < 1000; ++i) {
+    policy.addRequest();
+  }
+  int hedges = 0;
+  while (policy.tryHedge()) {
+    ++hedges;
+  }
+  EXPECT_EQ(10, hedges);
+}
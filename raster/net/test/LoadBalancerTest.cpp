@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "raster/net/LoadBalancer.h"
+#include <map>
+#include <gtest/gtest.h>
+
+using namespace rdd;
+
+namespace {
+
+const std::vector<std::string> kAddrs = {
+  "127.0.0.1:8001", "127.0.0.1:8002", "127.0.0.1:8003", "127.0.0.1:8004",
+};
+
+int pickPort(LoadBalancer& lb, uint64_t key, uint64_t latency = 1000,
+             bool ok = true) {
+  auto replica = lb.pick(key);
+  lb.done(replica, latency, ok, 100000);
+  return replica->peer.port();
+}
+
+}
+
+TEST(LoadBalancer, p2cPrefersFast) {
+  LoadBalancer lb("p2c", LoadBalancer::kP2C);
+  lb.setReplicas({kAddrs[0], kAddrs[1]});
+  std::map<int, int> picks;
+  for (int i = 0; i < 100; ++i) {
+    auto replica = lb.pick();
+    int port = replica->peer.port();
+    lb.done(replica, port == 8001 ? 1000 : 50000, true, 100000);
+    ++picks[port];
+  }
+  // each measured once, then the fast one wins
+  EXPECT_LE(98, picks[8001]);
+  EXPECT_LE(1, picks[8002]);
+}
+
+TEST(LoadBalancer, p2cAvoidsBusy) {
+  LoadBalancer lb("p2c", LoadBalancer::kP2C);
+  lb.setReplicas({kAddrs[0], kAddrs[1]});
+  for (int i = 0; i < 10; ++i) {
+    pickPort(lb, 0);
+  }
+  auto busy = lb.pick();
+  EXPECT_EQ(1, busy->inflight.load());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_NE(busy->peer.port(), pickPort(lb, 0));
+  }
+  lb.done(busy, 1000, true, 100000);
+  EXPECT_EQ(0, busy->inflight.load());
+}
+
+TEST(LoadBalancer, hashMovesOnlyRemovedKeys) {
+  LoadBalancer lb("hash", LoadBalancer::kHash);
+  lb.setReplicas(kAddrs);
+  std::map<uint64_t, int> before;
+  std::map<int, int> spread;
+  for (uint64_t k = 0; k < 1000; ++k) {
+    uint64_t key = LoadBalancer::hash(std::to_string(k));
+    before[key] = pickPort(lb, key);
+    EXPECT_EQ(before[key], pickPort(lb, key));
+    ++spread[before[key]];
+  }
+  EXPECT_EQ(4, spread.size());
+
+  lb.setReplicas({kAddrs[0], kAddrs[1], kAddrs[3]});
+  for (auto& p : before) {
+    int port = pickPort(lb, p.first);
+    if (p.second != 8003) {
+      EXPECT_EQ(p.second, port);
+    } else {
+      EXPECT_NE(8003, port);
+    }
+  }
+}
+
+TEST(LoadBalancer, ejectFailing) {
+  LoadBalancer lb("hash", LoadBalancer::kHash);
+  EjectOption eject;
+  eject.failures = 3;
+  eject.time = 10000000;
+  eject.maxPercent = 50;
+  lb.setReplicas(kAddrs, eject);
+  // a key on each replica
+  std::map<int, uint64_t> keys;
+  for (uint64_t k = 0; keys.size() < kAddrs.size(); ++k) {
+    uint64_t key = LoadBalancer::hash(std::to_string(k));
+    keys.emplace(pickPort(lb, key), key);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(8001, pickPort(lb, keys[8001], 1000, false));
+  }
+  EXPECT_NE(8001, pickPort(lb, keys[8001]));
+  EXPECT_EQ(8002, pickPort(lb, keys[8002]));
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(8002, pickPort(lb, keys[8002], 1000, false));
+  }
+  EXPECT_NE(8002, pickPort(lb, keys[8002]));
+  // at most half ejected, the third one stays
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(8003, pickPort(lb, keys[8003], 1000, false));
+  }
+  EXPECT_EQ(8003, pickPort(lb, keys[8003]));
+}
+
+TEST(LoadBalancer, keepStatsOnReload) {
+  LoadBalancer lb("p2c", LoadBalancer::kP2C);
+  lb.setReplicas({kAddrs[0]});
+  auto replica = lb.pick();
+  lb.done(replica, 5000, true, 100000);
+  lb.setReplicas({kAddrs[0], kAddrs[1]});
+  EXPECT_EQ(2, lb.count());
+  std::shared_ptr<LoadBalancer::Replica> kept;
+  while (!kept || kept->peer.port() != 8001) {
+    kept = lb.pick();
+    lb.done(kept, 5000, true, 100000);
+  }
+  EXPECT_EQ(replica, kept);
+}
+
+TEST(LoadBalancerManager, setupAndGet) {
+  LoadBalancerManager manager;
+  EXPECT_EQ(nullptr, manager.getBalancer("a"));
+  manager.setupBalancer("a", LoadBalancer::kHash, {kAddrs[0]}, 10000000);
+  auto lb = manager.getBalancer("a");
+  ASSERT_NE(nullptr, lb);
+  EXPECT_EQ(1, lb->count());
+  manager.setupBalancer("a", LoadBalancer::kP2C, kAddrs, 10000000);
+  EXPECT_EQ(lb, manager.getBalancer("a"));
+  EXPECT_EQ(4, lb->count());
+}
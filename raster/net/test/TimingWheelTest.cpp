@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "raster/net/TimingWheel.h"
+#include "accelerator/Time.h"
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace rdd;
+
+namespace {
+
+const uint64_t kTick = 1000;
+
+// timers of the delays (us), which record their index when fired
+struct Timers {
+  explicit Timers(const std::vector<uint64_t>& delays)
+    : timers(delays.size()) {
+    for (size_t i = 0; i < timers.size(); ++i) {
+      timers[i].callback = [this, i]() { fired.push_back(i); };
+    }
+  }
+
+  std::vector<TimingWheel::Timer> timers;
+  std::vector<size_t> fired;
+};
+
+}
+
+TEST(TimingWheel, fireInOrder) {
+  uint64_t base = acc::timestampNow();
+  TimingWheel wheel(kTick);
+  // level 0, 2, 1, 0, 3 and 1 of the wheel
+  std::vector<uint64_t> delays = {
+    100000, 100000000, 1000000, 3000, 20000000000, 2000000,
+  };
+  Timers t(delays);
+  for (size_t i = 0; i < delays.size(); ++i) {
+    wheel.schedule(&t.timers[i], delays[i]);
+  }
+  EXPECT_EQ(6, wheel.size());
+
+  EXPECT_EQ(3, wheel.advance(base + 1010000));
+  EXPECT_EQ(std::vector<size_t>({3, 0, 2}), t.fired);
+  EXPECT_EQ(3, wheel.advance(base + 30000000000));
+  EXPECT_EQ(std::vector<size_t>({3, 0, 2, 5, 1, 4}), t.fired);
+  EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimingWheel, neverEarly) {
+  uint64_t base = acc::timestampNow();
+  TimingWheel wheel(kTick);
+  Timers t({50000, 300000});
+  wheel.schedule(&t.timers[0], 50000);
+  wheel.schedule(&t.timers[1], 300000);
+  EXPECT_EQ(0, wheel.advance(base + 49000));
+  EXPECT_TRUE(t.timers[0].scheduled());
+  EXPECT_EQ(1, wheel.advance(base + 60000));
+  EXPECT_FALSE(t.timers[0].scheduled());
+  // cascaded down from level 1 on the way
+  EXPECT_EQ(0, wheel.advance(base + 299000));
+  EXPECT_EQ(1, wheel.advance(base + 310000));
+  EXPECT_EQ(std::vector<size_t>({0, 1}), t.fired);
+}
+
+TEST(TimingWheel, cancel) {
+  uint64_t base = acc::timestampNow();
+  TimingWheel wheel(kTick);
+  Timers t({10000, 10000, 500000});
+  for (auto& timer : t.timers) {
+    wheel.schedule(&timer, 10000);
+  }
+  wheel.schedule(&t.timers[2], 500000);  // rescheduled
+  wheel.cancel(&t.timers[0]);
+  EXPECT_FALSE(t.timers[0].scheduled());
+  EXPECT_EQ(2, wheel.size());
+  wheel.cancel(&t.timers[0]);  // not scheduled, no-op
+  EXPECT_EQ(2, wheel.size());
+
+  EXPECT_EQ(1, wheel.advance(base + 20000));
+  wheel.cancel(&t.timers[2]);
+  EXPECT_EQ(0, wheel.advance(base + 1000000));
+  EXPECT_EQ(std::vector<size_t>({1}), t.fired);
+  EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimingWheel, rescheduleFromCallback) {
+  uint64_t base = acc::timestampNow();
+  TimingWheel wheel(kTick);
+  TimingWheel::Timer timer;
+  int fired = 0;
+  timer.callback = [&]() {
+    if (++fired < 3) {
+      wheel.schedule(&timer, 0);  // next tick, not this one
+    }
+  };
+  wheel.schedule(&timer, 10000);
+  EXPECT_EQ(3, wheel.advance(base + 100000));
+  EXPECT_EQ(3, fired);
+  EXPECT_FALSE(timer.scheduled());
+}
+
+TEST(TimingWheel, freeFromCallback) {
+  uint64_t base = acc::timestampNow();
+  TimingWheel wheel(kTick);
+  std::unique_ptr<TimingWheel::Timer> timer(new TimingWheel::Timer());
+  TimingWheel::Timer other;
+  bool fired = false;
+  timer->callback = [&]() { timer.reset(); };
+  other.callback = [&]() { fired = true; };
+  wheel.schedule(timer.get(), 10000);
+  wheel.schedule(&other, 10000);
+  EXPECT_EQ(2, wheel.advance(base + 20000));
+  EXPECT_FALSE(timer);
+  EXPECT_TRUE(fired);
+}
+
+TEST(SharedTimingWheel, fireAndCancel) {
+  uint64_t base = acc::timestampNow();
+  SharedTimingWheel wheel;
+  uint64_t tick = wheel.tick();
+  TimingWheel::Timer a, b;
+  int fired = 0;
+  a.callback = [&]() {
+    if (++fired < 2) {
+      wheel.schedule(&a, 0);  // no deadlock on its own lock
+    }
+  };
+  b.callback = [&]() { ADD_FAILURE() << "cancelled timer fired"; };
+  wheel.schedule(&a, tick);
+  wheel.schedule(&b, tick);
+  EXPECT_TRUE(wheel.cancel(&b));
+  EXPECT_FALSE(wheel.cancel(&b));
+  wheel.advance(base + 10 * tick);
+  wheel.advance(base + 20 * tick);
+  EXPECT_EQ(2, fired);
+  EXPECT_FALSE(wheel.cancel(&a));
+  EXPECT_EQ(0, wheel.size());
+}
@@ -66,6 +66,15 @@ bool BinaryAsyncClient::fetch(acc::ByteRange& response, const acc::ByteRange& re
           recv(response));
 }
 
+#if RDD_HAVE_COROUTINE
+CoTask<bool> BinaryAsyncClient::coFetch(acc::ByteRange& response,
+                                        const acc::ByteRange& request) {
+  co_return (send(request) &&
+             co_await coYield() &&
+             recv(response));
+}
+#endif
+
 std::shared_ptr<Channel> BinaryAsyncClient::makeChannel() {
   return std::make_shared<Channel>(
       peer_,
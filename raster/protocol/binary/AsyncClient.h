@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "raster/coroutine/Coroutine.h"
 #include "raster/net/AsyncClient.h"
 
 namespace rdd {
@@ -40,6 +41,12 @@ class BinaryAsyncClient : public AsyncClient {
 
   bool fetch(acc::ByteRange& response, const acc::ByteRange& request);
 
+#if RDD_HAVE_COROUTINE
+  // fetch in a CoProcessor
+  CoTask<bool> coFetch(acc::ByteRange& response,
+                       const acc::ByteRange& request);
+#endif
+
  protected:
   std::shared_ptr<Channel> makeChannel() override;
 };
@@ -32,4 +32,10 @@ void BinaryProcessor::run() {
   }
 }
 
+void BinaryProcessor::reject() {
+  auto transport = event_->transport<BinaryTransport>();
+  transport->sendHeader(0);
+  transport->sendBody(acc::IOBuf::create(0));
+}
+
 } // namespace rdd
@@ -30,6 +30,9 @@ class BinaryProcessor : public Processor {
 
   void run() override;
 
+  // Reply an empty body.
+  void reject() override;
+
  private:
   acc::ByteRange ibuf_;
   acc::ByteRange obuf_;
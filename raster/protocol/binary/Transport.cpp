@@ -25,6 +25,8 @@ void BinaryTransport::reset() {
   headerSize_ = 0;
   headersComplete_ = false;
   header = 0;
+  bodySize_ = 0;
+  readHint_ = 0;
   if (body) {
     body->clear();
   }
@@ -38,14 +40,18 @@ void BinaryTransport::processReadData() {
       break;
     }
     readBuf_.trimStart(bytesParsed);
+    if (state_ == kFinish) {
+      break;
+    }
   }
 }
 
 size_t BinaryTransport::onIngress(const acc::IOBuf& buf) {
   std::unique_ptr<acc::IOBuf> clone(buf.clone());
+  size_t headerCopy = 0;
   if (!headersComplete_) {
     size_t headerLeft = sizeof(header) - headerSize_;
-    size_t headerCopy = std::min(headerLeft, buf.length());
+    headerCopy = std::min(headerLeft, buf.length());
     memcpy(headerBuf_ + headerSize_, buf.data(), headerCopy);
     headerSize_ += headerCopy;
     clone->trimStart(headerCopy);
@@ -54,17 +60,30 @@ size_t BinaryTransport::onIngress(const acc::IOBuf& buf) {
       headersComplete_ = true;
     }
   }
-  if (clone->length() > 0) {
+  if (headersComplete_) {
+    // stop at the frame end, the rest is a pipelined request
+    size_t bodyLeft = header - bodySize_;
+    if (clone->length() > bodyLeft) {
+      clone->trimEnd(clone->length() - bodyLeft);
+    }
+  }
+  size_t bodyCopy = clone->length();
+  if (bodyCopy > 0) {
+    bodySize_ += bodyCopy;
     if (body) {
       body->appendChain(std::move(clone));
     } else {
       body = std::move(clone);
     }
   }
-  if (body && body->computeChainDataLength() == header) {
-    state_ = kFinish;
+  if (headersComplete_) {
+    if (bodySize_ == header) {
+      state_ = kFinish;
+    } else {
+      readHint_ = header - bodySize_;
+    }
   }
-  return buf.length();
+  return headerCopy + bodyCopy;
 }
 
 void BinaryTransport::sendHeader(uint32_t header) {
@@ -44,6 +44,7 @@ class BinaryTransport : public Transport {
   uint8_t headerBuf_[4];
   size_t headerSize_;
   bool headersComplete_;
+  size_t bodySize_;
 };
 
 class BinaryTransportFactory : public TransportFactory {
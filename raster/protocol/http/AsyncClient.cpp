@@ -67,6 +67,15 @@ bool HTTPAsyncClient::fetch(const HTTPMessage& headers,
           recv());
 }
 
+#if RDD_HAVE_COROUTINE
+CoTask<bool> HTTPAsyncClient::coFetch(const HTTPMessage& headers,
+                                      std::unique_ptr<acc::IOBuf> body) {
+  co_return (send(headers, std::move(body)) &&
+             co_await coYield() &&
+             recv());
+}
+#endif
+
 HTTPMessage* HTTPAsyncClient::message() const {
   return event_->transport<HTTPTransport>()->headers.get();
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "raster/coroutine/Coroutine.h"
 #include "raster/net/AsyncClient.h"
 #include "raster/protocol/http/HTTPHeaders.h"
 #include "raster/protocol/http/HTTPMessage.h"
@@ -42,6 +43,12 @@ class HTTPAsyncClient : public AsyncClient {
 
   bool fetch(const HTTPMessage& headers, std::unique_ptr<acc::IOBuf> body);
 
+#if RDD_HAVE_COROUTINE
+  // fetch in a CoProcessor
+  CoTask<bool> coFetch(const HTTPMessage& headers,
+                       std::unique_ptr<acc::IOBuf> body);
+#endif
+
   HTTPMessage* message() const;
   acc::IOBuf* body() const;
   HTTPHeaders* trailers() const;
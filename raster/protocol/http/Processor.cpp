@@ -67,10 +67,27 @@ void HTTPProcessor::run() {
   }
 }
 
+void HTTPProcessor::reject() {
+  handler_->response.setupTransport(event_->transport<HTTPTransport>());
+  handler_->sendError(503);
+}
+
 std::unique_ptr<Processor> HTTPProcessorFactory::create(Event* event) {
+  return acc::make_unique<HTTPProcessor>(event, route(event));
+}
+
+bool HTTPProcessorFactory::isHeavy(Event* event) {
+  return route(event)->isHeavy();
+}
+
+const std::shared_ptr<RequestHandler>&
+HTTPProcessorFactory::route(Event* event) {
+  // matched once per message, isHeavy() and create() both need it
   auto transport = event->transport<HTTPTransport>();
-  auto url = transport->headers->getURL();
-  return acc::make_unique<HTTPProcessor>(event, router_(url));
+  if (!transport->handler) {
+    transport->handler = router_(transport->headers->getURL());
+  }
+  return transport->handler;
 }
 
 } // namespace rdd
@@ -32,6 +32,9 @@ class HTTPProcessor : public Processor {
 
   void run() override;
 
+  // Reply 503.
+  void reject() override;
+
  protected:
   std::shared_ptr<RequestHandler> handler_;
 };
@@ -46,7 +49,11 @@ class HTTPProcessorFactory : public ProcessorFactory {
 
   std::unique_ptr<Processor> create(Event* event) override;
 
+  bool isHeavy(Event* event) override;
+
  private:
+  const std::shared_ptr<RequestHandler>& route(Event* event);
+
   Router router_;
 };
 
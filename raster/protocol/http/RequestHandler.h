@@ -38,6 +38,9 @@ class RequestHandler {
   virtual void prepare() {}
   virtual void finish() {}
 
+  // Run on the CPU pool for a service with io_run.
+  virtual bool isHeavy() const { return false; }
+
   void handleException(const HTTPException& e);
   void handleException(const std::exception& e);
   void handleException();
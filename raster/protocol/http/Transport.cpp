@@ -152,6 +152,7 @@ void HTTPTransport::onMessageBegin(HTTPMessage* msg) {
 
 void HTTPTransport::onHeadersComplete(std::unique_ptr<HTTPMessage> msg) {
   headers = std::move(msg);
+  handler = nullptr;
 }
 
 void HTTPTransport::onBody(std::unique_ptr<acc::IOBuf> chain) {
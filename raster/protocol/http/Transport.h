@@ -21,6 +21,8 @@
 
 namespace rdd {
 
+class RequestHandler;
+
 class HTTPTransport : public Transport, public HTTP1xCodec::Callback {
  public:
   HTTPTransport(TransportDirection direction)
@@ -46,6 +48,9 @@ class HTTPTransport : public Transport, public HTTP1xCodec::Callback {
   std::unique_ptr<acc::IOBuf> body;
   std::unique_ptr<HTTPHeaders> trailers;
 
+  // routed for the current message, by HTTPProcessorFactory
+  std::shared_ptr<RequestHandler> handler;
+
  private:
   // HTTP1xCodec::Callback
   void onMessageBegin(HTTPMessage* msg) override;
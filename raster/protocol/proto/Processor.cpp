@@ -16,39 +16,78 @@
 
 #include "raster/protocol/proto/Processor.h"
 
+#include "accelerator/stats/Monitor.h"
 #include "raster/protocol/binary/Transport.h"
 #include "raster/protocol/proto/Message.h"
 
 namespace rdd {
 
 void PBProcessor::run() {
+  int type;
+  std::string callId;
+  const google::protobuf::MethodDescriptor* descriptor = nullptr;
+  std::shared_ptr<google::protobuf::Message> request;
+  if (!parse(type, callId, descriptor, request)) {
+    return;
+  }
+  try {
+    if (type == proto::REQUEST_MSG) {
+      process(callId, descriptor, request);
+    } else {
+      cancel(callId);
+    }
+  } catch (std::exception& e) {
+    ACCLOG(WARN) << "catch exception: " << e.what();
+  } catch (...) {
+    ACCLOG(WARN) << "catch unknown exception";
+  }
+}
+
+void PBProcessor::reject() {
+  int type;
+  std::string callId;
+  const google::protobuf::MethodDescriptor* descriptor = nullptr;
+  std::shared_ptr<google::protobuf::Message> request;
+  if (!parse(type, callId, descriptor, request)) {
+    return;
+  }
+  if (type == proto::REQUEST_MSG) {
+    PBRpcController controller;
+    controller.SetFailed("server overloaded");
+    sendResponse(callId, &controller, nullptr);
+  } else {
+    cancel(callId);
+  }
+}
+
+bool PBProcessor::parse(
+    int& type,
+    std::string& callId,
+    const google::protobuf::MethodDescriptor*& method,
+    std::shared_ptr<google::protobuf::Message>& request) {
   auto transport = event_->transport<BinaryTransport>();
   try {
     acc::io::Cursor in(transport->body.get());
-    int type = proto::readInt(in);
+    type = proto::readInt(in);
     switch (type) {
-      case proto::REQUEST_MSG: {
-        std::string callId;
-        std::shared_ptr<google::protobuf::Message> request;
-        const google::protobuf::MethodDescriptor* descriptor = nullptr;
-        proto::parseRequestFrom(in, callId, descriptor, request);
-        process(callId, descriptor, request);
-        break;
-      }
-      case proto::CANCEL_MSG: {
-        std::string callId;
+      case proto::REQUEST_MSG:
+        proto::parseRequestFrom(in, callId, method, request);
+        return true;
+      case proto::CANCEL_MSG:
         proto::parseCancelFrom(in, callId);
-        cancel(callId);
-        break;
-      }
+        return true;
       default:
-        ACCLOG(FATAL) << "unknown message type: " << type;
+        ACCLOG(WARN) << *event_ << " unknown message type: " << type
+          << ", drop";
+        ACCMON_CNT("proto.bad_message");
+        return false;
     }
   } catch (std::exception& e) {
     ACCLOG(WARN) << "catch exception: " << e.what();
   } catch (...) {
     ACCLOG(WARN) << "catch unknown exception";
   }
+  return false;
 }
 
 void PBProcessor::process(
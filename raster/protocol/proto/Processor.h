@@ -32,7 +32,17 @@ class PBProcessor : public Processor {
 
   void run() override;
 
+  // Reply a failed controller to the request.
+  void reject() override;
+
  private:
+  // Parse the message, false for a bad one (dropped, no call to reply).
+  bool parse(
+      int& type,
+      std::string& callId,
+      const google::protobuf::MethodDescriptor*& method,
+      std::shared_ptr<google::protobuf::Message>& request);
+
   void process(
       const std::string& callId,
       const google::protobuf::MethodDescriptor* method,
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "accelerator/Memory.h"
+#include "raster/protocol/thrift/Util.h"
+
+namespace rdd {
+
+template <class C>
+TMuxClient<C>::TMuxClient(const ClientOption& option) {
+  init(option.peer, option.timeout);
+}
+
+template <class C>
+TMuxClient<C>::TMuxClient(const Peer& peer,
+                          const TimeoutOption& timeout) {
+  init(peer, timeout);
+}
+
+template <class C>
+TMuxClient<C>::TMuxClient(const Peer& peer,
+                          uint64_t ctimeout,
+                          uint64_t rtimeout,
+                          uint64_t wtimeout) {
+  init(peer, {ctimeout, rtimeout, wtimeout});
+}
+
+template <class C>
+template <class Res, class... Req>
+bool TMuxClient<C>::fetch(
+    void (C::*recvFunc)(Res&), Res& response,
+    void (C::*sendFunc)(const Req&...), const Req&... requests) {
+  if (!call(sendFunc, requests...)) {
+    return false;
+  }
+  (client_.get()->*recvFunc)(response);
+  return true;
+}
+
+template <class C>
+template <class Res, class... Req>
+bool TMuxClient<C>::fetch(
+    Res (C::*recvFunc)(void), Res& response,
+    void (C::*sendFunc)(const Req&...), const Req&... requests) {
+  if (!call(sendFunc, requests...)) {
+    return false;
+  }
+  response = (client_.get()->*recvFunc)();
+  return true;
+}
+
+template <class C>
+template <class... Req>
+bool TMuxClient<C>::call(
+    void (C::*sendFunc)(const Req&...), const Req&... requests) {
+  pobuf_->resetBuffer();
+  (client_.get()->*sendFunc)(requests...);
+
+  MuxConnection* conn = connection();
+  int32_t seqid = conn->nextId();
+  thrift::setSeqId(pobuf_.get(), seqid);
+  uint8_t* p;
+  uint32_t n;
+  pobuf_->getBuffer(&p, &n);
+  if (!conn->call(seqid, std::string((const char*)p, n), response_,
+                  timeout_)) {
+    return false;
+  }
+  pibuf_->resetBuffer((uint8_t*)response_.data(), response_.size());
+  return true;
+}
+
+template <class C>
+void TMuxClient<C>::init(const Peer& peer, const TimeoutOption& timeout) {
+  peer_ = peer;
+  timeout_ = timeout;
+
+  pibuf_.reset(new apache::thrift::transport::TMemoryBuffer());
+  pobuf_.reset(new apache::thrift::transport::TMemoryBuffer());
+  piprot_.reset(new apache::thrift::protocol::TBinaryProtocol(pibuf_));
+  poprot_.reset(new apache::thrift::protocol::TBinaryProtocol(pobuf_));
+
+  client_ = acc::make_unique<C>(piprot_, poprot_);
+}
+
+template <class C>
+MuxConnection* TMuxClient<C>::connection() {
+  if (!conn_ || conn_->broken()) {
+    conn_ = MuxConnection::get(peer_, timeout_, [](const std::string& body) {
+      apache::thrift::transport::TMemoryBuffer buf(
+          (uint8_t*)body.data(), body.size());
+      return thrift::getSeqId(&buf);
+    });
+  }
+  return conn_.get();
+}
+
+} // namespace rdd
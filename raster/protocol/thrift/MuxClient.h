@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "raster/3rd/thrift/protocol/TBinaryProtocol.h"
+#include "raster/3rd/thrift/transport/TBufferTransports.h"
+#include "raster/net/MuxConnection.h"
+
+namespace rdd {
+
+/*
+ * Thrift client sharing one connection of the peer with all the other
+ * TMuxClients of it, calls are tagged and matched by seqid.
+ *
+ * The backend must be framed (as TAsyncServer) and answer with the
+ * seqid of the request.  The read and write timeouts are the client's,
+ * the connect timeout is the one of the client that made the connection.
+ * A broken connection is replaced on the next call.
+ */
+template <class C>
+class TMuxClient {
+ public:
+  TMuxClient(const ClientOption& option);
+
+  TMuxClient(const Peer& peer,
+             const TimeoutOption& timeout);
+
+  TMuxClient(const Peer& peer,
+             uint64_t ctimeout = 100000,
+             uint64_t rtimeout = 1000000,
+             uint64_t wtimeout = 300000);
+
+  template <class Res, class... Req>
+  bool fetch(void (C::*recvFunc)(Res&), Res& _return,
+             void (C::*sendFunc)(const Req&...), const Req&... requests);
+
+  template <class Res, class... Req>
+  bool fetch(Res (C::*recvFunc)(void), Res& _return,
+             void (C::*sendFunc)(const Req&...), const Req&... requests);
+
+ private:
+  void init(const Peer& peer, const TimeoutOption& timeout);
+
+  // shared connection of peer_, renewed if broken
+  MuxConnection* connection();
+
+  template <class... Req>
+  bool call(void (C::*sendFunc)(const Req&...), const Req&... requests);
+
+  Peer peer_;
+  TimeoutOption timeout_;
+  std::shared_ptr<MuxConnection> conn_;
+  std::string response_;
+
+  boost::shared_ptr< ::apache::thrift::transport::TMemoryBuffer> pibuf_;
+  boost::shared_ptr< ::apache::thrift::transport::TMemoryBuffer> pobuf_;
+  boost::shared_ptr< ::apache::thrift::protocol::TBinaryProtocol> piprot_;
+  boost::shared_ptr< ::apache::thrift::protocol::TBinaryProtocol> poprot_;
+
+  std::unique_ptr<C> client_;
+};
+
+} // namespace rdd
+
+#include "raster/protocol/thrift/MuxClient-inl.h"
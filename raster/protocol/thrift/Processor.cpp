@@ -50,6 +50,41 @@ void TProcessor::run() {
   }
 }
 
+void TProcessor::reject() {
+  auto transport = event_->transport<BinaryTransport>();
+  if (writeReject(transport->body.get())) {
+    uint8_t* p;
+    uint32_t n;
+    pobuf_->getBuffer(&p, &n);
+    transport->sendHeader(n);
+    transport->sendBody(acc::IOBuf::copyBuffer(p, n));
+  }
+}
+
+bool TProcessor::writeReject(acc::IOBuf* body) {
+  using apache::thrift::TApplicationException;
+  try {
+    auto range = body->coalesce();
+    pibuf_->resetBuffer((uint8_t*)range.data(), range.size());
+    std::string name;
+    apache::thrift::protocol::TMessageType type;
+    int32_t seqid;
+    piprot_->readMessageBegin(name, type, seqid);
+    TApplicationException e(TApplicationException::INTERNAL_ERROR,
+                            "server overloaded");
+    poprot_->writeMessageBegin(
+        name, apache::thrift::protocol::T_EXCEPTION, seqid);
+    e.write(poprot_.get());
+    poprot_->writeMessageEnd();
+    poprot_->getTransport()->writeEnd();
+    poprot_->getTransport()->flush();
+    return true;
+  } catch (std::exception& e) {
+    ACCLOG(WARN) << "catch exception: " << e.what();
+  }
+  return false;
+}
+
 void TZlibProcessor::run() {
   auto transport = event_->transport<ZlibTransport>();
   try {
@@ -69,4 +104,14 @@ void TZlibProcessor::run() {
   }
 }
 
+void TZlibProcessor::reject() {
+  auto transport = event_->transport<ZlibTransport>();
+  if (writeReject(transport->body.get())) {
+    uint8_t* p;
+    uint32_t n;
+    pobuf_->getBuffer(&p, &n);
+    transport->sendBody(acc::IOBuf::copyBuffer(p, n));
+  }
+}
+
 } // namespace rdd
@@ -19,6 +19,7 @@
 #include <arpa/inet.h>
 #include <boost/shared_ptr.hpp>
 
+#include "raster/3rd/thrift/TApplicationException.h"
 #include "raster/3rd/thrift/TProcessor.h"
 #include "raster/3rd/thrift/protocol/TBinaryProtocol.h"
 #include "raster/3rd/thrift/transport/TBufferTransports.h"
@@ -37,7 +38,13 @@ class TProcessor : public Processor {
 
   void run() override;
 
+  // Reply a TApplicationException to the request.
+  void reject() override;
+
  protected:
+  // Write the exception for the request in body to pobuf_.
+  bool writeReject(acc::IOBuf* body);
+
   std::unique_ptr< ::apache::thrift::TProcessor> processor_;
   boost::shared_ptr< ::apache::thrift::transport::TMemoryBuffer> pibuf_;
   boost::shared_ptr< ::apache::thrift::transport::TMemoryBuffer> pobuf_;
@@ -55,6 +62,8 @@ class TZlibProcessor : public TProcessor {
   ~TZlibProcessor() override {}
 
   void run() override;
+
+  void reject() override;
 };
 
 template <class P, class If, class ProcessorType>